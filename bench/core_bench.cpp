@@ -0,0 +1,596 @@
+/******************************************************************************/
+/* Mednafen Sega Saturn Emulation Module                                      */
+/******************************************************************************/
+/* core_bench.cpp - Headless whole-core benchmark
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+//
+// Minimal libretro frontend, linked directly against the core's objects: loads a disc image(with the BIOS from the
+// system directory), runs a fixed number of frames with stub video/audio callbacks while replaying an input log, and
+// reports frames per second, host time per subsystem, and hashes of the last frame(or with -H, of all frames) and of
+// all audio output.
+//
+// Usage: core_bench [-s system_dir] [-S save_dir] [-n frames] [-i input_log] [-o key=value]... [-t state_count] [-F] [-H] [-m mix_kernel] [-v] content
+//
+// Build and run with "make bench BENCH_ARGS='...'".
+//
+// The save directory defaults to a new, empty temporary directory, and the RTC isn't set from the host clock, so
+// that runs are repeatable; with the same build, content, input log and options, the hashes must not change.
+//
+// Input log format: one change per line, "<frame> <port> <buttons>", where <buttons> is a bitmask of
+// RETRO_DEVICE_ID_JOYPAD_* bits(e.g. 0x8 for START) that port holds from that frame on; lines must be in frame
+// order.  Blank lines and lines starting with '#' are ignored.
+//
+// With -t, the state at the end of the run is then saved and loaded again state_count times with
+// retro_serialize()/retro_unserialize(), and the time taken is reported along with a hash of the state; saving the
+// loaded state once more must give the same bytes.  -F makes the frontend ask for fast savestates(bit 2 of
+// RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE), as it would for run-ahead, rewind and netplay states.
+//
+// -m makes the VDP2 renderer use the named color calculation/offset/shadow kernel("scalar", "sse2" or "avx2") rather
+// than the fastest one the CPU supports; with -H, every kernel must give the same video hash for the same run.  "make
+// bench-vdp2-mix-frames BENCH_ARGS='...'" checks that.
+//
+
+#include "mednafen/ss/ss.h"
+#include "mednafen/ss/vdp2_render.h"
+#include "mednafen/hash/md5.h"
+#include "libretro.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+enum : unsigned { MAX_PORTS = 12 };
+
+static std::string SystemDir = ".";
+static std::string SaveDir;
+static std::map<std::string, std::string> Options;
+static std::map<std::string, std::string> OptionOverrides;
+static bool Verbose = false;
+static int AVEnable = 0x3;
+
+struct InputEvent
+{
+ uint64 frame;
+ unsigned port;
+ uint16 buttons;
+};
+
+static std::vector<InputEvent> InputLog;
+static uint16 PortButtons[MAX_PORTS];
+
+static const uint32* LastFrame;
+static unsigned LastFrameWidth, LastFrameHeight;
+static size_t LastFramePitch;
+static bool HashAllFrames = false;
+static md5_context VideoHash;
+static uint64 VideoFrames;
+static md5_context AudioHash;
+static uint64 AudioFrames;
+
+static void LogCallback(enum retro_log_level level, const char* fmt, ...)
+{
+ va_list ap;
+
+ if(level < RETRO_LOG_WARN && !Verbose)
+  return;
+
+ va_start(ap, fmt);
+ vfprintf(stderr, fmt, ap);
+ va_end(ap);
+}
+
+static void AddOptionDefaults(const struct retro_core_option_v2_definition* defs)
+{
+ for(; defs->key; defs++)
+ {
+  if(defs->default_value)
+   Options[defs->key] = defs->default_value;
+ }
+}
+
+static bool EnvironmentCallback(unsigned cmd, void* data)
+{
+ switch(cmd)
+ {
+  case RETRO_ENVIRONMENT_GET_LOG_INTERFACE:
+	((struct retro_log_callback*)data)->log = LogCallback;
+	return true;
+
+  case RETRO_ENVIRONMENT_GET_SYSTEM_DIRECTORY:
+	*(const char**)data = SystemDir.c_str();
+	return true;
+
+  case RETRO_ENVIRONMENT_GET_SAVE_DIRECTORY:
+	*(const char**)data = SaveDir.c_str();
+	return true;
+
+  case RETRO_ENVIRONMENT_GET_CORE_OPTIONS_VERSION:
+	*(unsigned*)data = 2;
+	return true;
+
+  case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_V2:
+	AddOptionDefaults(((const struct retro_core_options_v2*)data)->definitions);
+	return true;
+
+  case RETRO_ENVIRONMENT_SET_CORE_OPTIONS_V2_INTL:
+	AddOptionDefaults(((const struct retro_core_options_v2_intl*)data)->us->definitions);
+	return true;
+
+  case RETRO_ENVIRONMENT_GET_VARIABLE:
+	{
+	 struct retro_variable* var = (struct retro_variable*)data;
+	 auto it = OptionOverrides.find(var->key);
+
+	 if(it == OptionOverrides.end())
+	 {
+	  it = Options.find(var->key);
+
+	  if(it == Options.end())
+	  {
+	   var->value = NULL;
+	   return false;
+	  }
+	 }
+
+	 var->value = it->second.c_str();
+	}
+	return true;
+
+  case RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE:
+	*(bool*)data = false;
+	return true;
+
+  case RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE:
+	*(int*)data = AVEnable;
+	return true;
+
+  case RETRO_ENVIRONMENT_SET_PIXEL_FORMAT:
+	return *(const enum retro_pixel_format*)data == RETRO_PIXEL_FORMAT_XRGB8888;
+ }
+
+ return false;
+}
+
+static void VideoCallback(const void* data, unsigned width, unsigned height, size_t pitch)
+{
+ if(!data)
+  return;
+
+ LastFrame = (const uint32*)data;
+ LastFrameWidth = width;
+ LastFrameHeight = height;
+ LastFramePitch = pitch;
+
+ if(HashAllFrames)
+ {
+  for(unsigned y = 0; y < height; y++)
+   VideoHash.update((const uint8*)data + y * pitch, width * sizeof(uint32));
+
+  VideoFrames++;
+ }
+}
+
+static void AudioSampleCallback(int16_t left, int16_t right)
+{
+ const int16_t s[2] = { left, right };
+
+ AudioHash.update((const uint8*)s, sizeof(s));
+ AudioFrames++;
+}
+
+static size_t AudioBatchCallback(const int16_t* data, size_t frames)
+{
+ AudioHash.update((const uint8*)data, frames * 2 * sizeof(int16_t));
+ AudioFrames += frames;
+
+ return frames;
+}
+
+static void InputPollCallback(void)
+{
+
+}
+
+static int16_t InputStateCallback(unsigned port, unsigned device, unsigned index, unsigned id)
+{
+ if(port >= MAX_PORTS || device != RETRO_DEVICE_JOYPAD)
+  return 0;
+
+ if(id == RETRO_DEVICE_ID_JOYPAD_MASK)
+  return PortButtons[port];
+
+ return (id < 16) ? ((PortButtons[port] >> id) & 1) : 0;
+}
+
+static bool LoadInputLog(const char* path)
+{
+ FILE* fp = fopen(path, "rb");
+ char line[256];
+ unsigned line_num = 0;
+
+ if(!fp)
+ {
+  fprintf(stderr, "Error opening input log \"%s\".\n", path);
+  return false;
+ }
+
+ while(fgets(line, sizeof(line), fp))
+ {
+  unsigned long long frame;
+  unsigned port;
+  int buttons;
+  const char* p = line;
+
+  line_num++;
+
+  while(*p == ' ' || *p == '\t')
+   p++;
+
+  if(*p == '#' || *p == '\r' || *p == '\n' || !*p)
+   continue;
+
+  if(sscanf(p, "%llu %u %i", &frame, &port, &buttons) != 3 || port >= MAX_PORTS || (!InputLog.empty() && frame < InputLog.back().frame))
+  {
+   fprintf(stderr, "%s:%u: Bad input log line.\n", path, line_num);
+   fclose(fp);
+   return false;
+  }
+
+  InputLog.push_back({ (uint64)frame, port, (uint16)buttons });
+ }
+
+ fclose(fp);
+
+ return true;
+}
+
+static std::string DigestToString(const uint8 (&digest)[16])
+{
+ std::string ret;
+ char tmp[3];
+
+ for(unsigned i = 0; i < 16; i++)
+ {
+  snprintf(tmp, sizeof(tmp), "%02x", digest[i]);
+  ret += tmp;
+ }
+
+ return ret;
+}
+
+static uint64 ClockNS(void)
+{
+ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void PrintTime(const char* name, const uint64 ns, const uint64 total_ns)
+{
+ printf("  %-24s %9.3f s  %5.1f%%\n", name, ns / 1e9, total_ns ? ns * 100.0 / total_ns : 0.0);
+}
+
+static bool BenchStates(const unsigned count)
+{
+ const size_t size = retro_serialize_size();
+ std::vector<uint8> state(size), check(size);
+ uint64 save_ns = 0, load_ns = 0;
+ uint8 digest[16];
+ md5_context state_hash;
+
+ for(unsigned i = 0; i < count; i++)
+ {
+  uint64 t = ClockNS();
+
+  if(!retro_serialize(state.data(), size))
+  {
+   fprintf(stderr, "retro_serialize() failed.\n");
+   return false;
+  }
+
+  save_ns += ClockNS() - t;
+  t = ClockNS();
+
+  if(!retro_unserialize(state.data(), size))
+  {
+   fprintf(stderr, "retro_unserialize() failed.\n");
+   return false;
+  }
+
+  load_ns += ClockNS() - t;
+ }
+
+ if(!retro_serialize(check.data(), size) || memcmp(state.data(), check.data(), size))
+ {
+  fprintf(stderr, "State saved after loading differs from the state loaded.\n");
+  return false;
+ }
+
+ state_hash.starts();
+ state_hash.update(state.data(), size);
+ state_hash.finish(digest);
+
+ printf("State: %zu bytes; save %.3f ms (%.1f MiB/s), load %.3f ms (%.1f MiB/s)\n", size,
+	save_ns / 1e6 / count, (double)size * count / 1048576 / (save_ns / 1e9),
+	load_ns / 1e6 / count, (double)size * count / 1048576 / (load_ns / 1e9));
+ printf("State hash: %s\n", DigestToString(digest).c_str());
+
+ return true;
+}
+
+// The core only writes plain files into the save directory.
+static void RemoveSaveDir(void)
+{
+ DIR* dp = opendir(SaveDir.c_str());
+
+ if(dp)
+ {
+  struct dirent* de;
+
+  while((de = readdir(dp)))
+  {
+   if(strcmp(de->d_name, ".") && strcmp(de->d_name, ".."))
+    unlink((SaveDir + "/" + de->d_name).c_str());
+  }
+
+  closedir(dp);
+ }
+
+ if(rmdir(SaveDir.c_str()))
+  fprintf(stderr, "Error removing temporary save directory \"%s\".\n", SaveDir.c_str());
+}
+
+static void Usage(const char* argv0)
+{
+ fprintf(stderr, "Usage: %s [-s system_dir] [-S save_dir] [-n frames] [-i input_log] [-o key=value]... [-t state_count] [-F] [-H] [-m mix_kernel] [-v] content\n", argv0);
+}
+
+int main(int argc, char* argv[])
+{
+ uint64 frame_count = 600;
+ const char* input_log_path = NULL;
+ unsigned state_count = 0;
+ char temp_save_dir[] = "/tmp/ss_bench_XXXXXX";
+ bool made_temp_save_dir = false;
+ int opt;
+
+ OptionOverrides["beetle_saturn_autortc"] = "disabled";
+
+ while((opt = getopt(argc, argv, "s:S:n:i:o:t:FHm:v")) != -1)
+ {
+  switch(opt)
+  {
+   case 's':
+	SystemDir = optarg;
+	break;
+
+   case 'S':
+	SaveDir = optarg;
+	break;
+
+   case 'n':
+	frame_count = strtoull(optarg, NULL, 10);
+	break;
+
+   case 'i':
+	input_log_path = optarg;
+	break;
+
+   case 'o':
+	{
+	 const char* eq = strchr(optarg, '=');
+
+	 if(!eq)
+	 {
+	  Usage(argv[0]);
+	  return 1;
+	 }
+
+	 OptionOverrides[std::string(optarg, eq - optarg)] = eq + 1;
+	}
+	break;
+
+   case 't':
+	state_count = strtoul(optarg, NULL, 10);
+	break;
+
+   case 'F':
+	AVEnable |= 0x4;
+	break;
+
+   case 'H':
+	HashAllFrames = true;
+	break;
+
+   case 'm':
+	if(!VDP2REND_ForceMixKernel(optarg))
+	{
+	 fprintf(stderr, "VDP2 mix kernel \"%s\" isn't available on this host.\n", optarg);
+	 return 1;
+	}
+	break;
+
+   case 'v':
+	Verbose = true;
+	break;
+
+   default:
+	Usage(argv[0]);
+	return 1;
+  }
+ }
+
+ if(optind != (argc - 1))
+ {
+  Usage(argv[0]);
+  return 1;
+ }
+
+ if(input_log_path && !LoadInputLog(input_log_path))
+  return 1;
+
+ if(SaveDir.empty())
+ {
+  if(!mkdtemp(temp_save_dir))
+  {
+   fprintf(stderr, "Error creating temporary save directory.\n");
+   return 1;
+  }
+
+  SaveDir = temp_save_dir;
+  made_temp_save_dir = true;
+ }
+ //
+ //
+ //
+ struct retro_game_info game_info;
+ struct retro_system_av_info av_info;
+
+ retro_set_environment(EnvironmentCallback);
+ retro_set_video_refresh(VideoCallback);
+ retro_set_audio_sample(AudioSampleCallback);
+ retro_set_audio_sample_batch(AudioBatchCallback);
+ retro_set_input_poll(InputPollCallback);
+ retro_set_input_state(InputStateCallback);
+ retro_init();
+
+ memset(&game_info, 0, sizeof(game_info));
+ game_info.path = argv[optind];
+
+ if(!retro_load_game(&game_info))
+ {
+  fprintf(stderr, "Error loading \"%s\".\n", argv[optind]);
+  retro_deinit();
+
+  if(made_temp_save_dir)
+   RemoveSaveDir();
+
+  return 1;
+ }
+
+ retro_get_system_av_info(&av_info);
+ AudioHash.starts();
+ VideoHash.starts();
+ //
+ //
+ //
+ VDP2Rend_WaitStats ws_start, ws_end;
+ size_t input_pos = 0;
+
+ memset(&SS_Profile, 0, sizeof(SS_Profile));
+ SS_ProfileActive = true;
+ VDP2REND_GetWaitStats(&ws_start);
+
+ const uint64 start_time = ClockNS();
+
+ for(uint64 frame = 0; frame < frame_count; frame++)
+ {
+  while(input_pos < InputLog.size() && InputLog[input_pos].frame <= frame)
+  {
+   PortButtons[InputLog[input_pos].port] = InputLog[input_pos].buttons;
+   input_pos++;
+  }
+
+  retro_run();
+ }
+
+ const uint64 run_ns = ClockNS() - start_time;
+
+ SS_ProfileActive = false;
+ VDP2REND_GetWaitStats(&ws_end);
+ //
+ //
+ //
+ static const char* const event_names[SS_EVENT__COUNT] =
+ {
+  NULL,
+  "SH-2 DMA (master)",
+  "SH-2 DMA (slave)",
+  "SCU DMA",
+  "SCU DSP",
+  "SMPC",
+  "VDP1",
+  "VDP2 (incl. frame end)",
+  "CDB",
+  "SCSP + 68K",
+  "Cart",
+  "Mid-frame sync",
+  NULL
+ };
+ uint64 events_ns = 0;
+ uint8 digest[16];
+ md5_context video_hash;
+
+ for(unsigned i = 0; i < SS_EVENT__COUNT; i++)
+  events_ns += SS_Profile.event_ns[i];
+
+ printf("%llu frames in %.3f s: %.2f fps (%.2fx realtime)\n", (unsigned long long)frame_count, run_ns / 1e9, frame_count / (run_ns / 1e9), frame_count / (run_ns / 1e9) / av_info.timing.fps);
+ printf("Emulation thread:\n");
+ PrintTime("SH-2 + bus", SS_Profile.emulate_ns - events_ns, run_ns);
+
+ for(unsigned i = 0; i < SS_EVENT__COUNT; i++)
+ {
+  if(event_names[i])
+   PrintTime(event_names[i], SS_Profile.event_ns[i], run_ns);
+ }
+
+ PrintTime("Frontend/other", run_ns - SS_Profile.emulate_ns, run_ns);
+ printf("VDP2 render thread:\n");
+ PrintTime("Drawing", ws_end.draw_ns - ws_start.draw_ns, run_ns);
+ PrintTime("Spinning", ws_end.spin_ns - ws_start.spin_ns, run_ns);
+ PrintTime("Sleeping", ws_end.park_ns - ws_start.park_ns, run_ns);
+
+ if(HashAllFrames)
+ {
+  VideoHash.finish(digest);
+  printf("Video hash: %s (all %llu frames)\n", DigestToString(digest).c_str(), (unsigned long long)VideoFrames);
+ }
+ else
+ {
+  video_hash.starts();
+
+  for(unsigned y = 0; LastFrame && y < LastFrameHeight; y++)
+   video_hash.update((const uint8*)((const uint8*)LastFrame + y * LastFramePitch), LastFrameWidth * sizeof(uint32));
+
+  video_hash.finish(digest);
+  printf("Video hash: %s (last frame, %ux%u)\n", DigestToString(digest).c_str(), LastFrameWidth, LastFrameHeight);
+ }
+
+ AudioHash.finish(digest);
+ printf("Audio hash: %s (%llu sample frames)\n", DigestToString(digest).c_str(), (unsigned long long)AudioFrames);
+
+ bool ret = true;
+
+ if(state_count)
+  ret = BenchStates(state_count);
+ //
+ //
+ //
+ retro_unload_game();
+ retro_deinit();
+
+ if(made_temp_save_dir)
+  RemoveSaveDir();
+
+ return ret ? 0 : 1;
+}
@@ -0,0 +1,278 @@
+/******************************************************************************/
+/* Mednafen Sega Saturn Emulation Module                                      */
+/******************************************************************************/
+/* event_sched.cpp - Event scheduler microbenchmark
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+//
+// Runs the same synthetic event workload through the heap-based event queue(mednafen/ss/events.inc) and the
+// sorted doubly-linked list it replaced, reports the median events dispatched per second for each over several runs,
+// and checks that both dispatched events in exactly the same order.
+//
+// Build and run with "make bench-events".
+//
+
+#include "mednafen/ss/ss.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace HeapSched
+{
+ static bool Running = true;
+ static sscpu_timestamp_t next_event_ts;
+ static event_list_entry events[SS_EVENT__COUNT];
+
+ #include "mednafen/ss/events.inc"
+
+ static void Init(void)
+ {
+  for(unsigned i = 0; i < SS_EVENT__COUNT; i++)
+   events[i].event_time = (i == SS_EVENT__SYNLAST) ? 0x7FFFFFFF : 0;
+
+  EventHeap_Init();
+  next_event_ts = EventHeap_Top()->event_time;
+ }
+
+ static NO_INLINE void Set(unsigned which, sscpu_timestamp_t ts) { HeapSched::SS_SetEventNT(&events[which], ts); }
+ static INLINE sscpu_timestamp_t NextTS(void) { return next_event_ts; }
+ static INLINE unsigned Top(void) { return EventHeap_Top() - events; }
+ static INLINE sscpu_timestamp_t Time(unsigned which) { return events[which].event_time; }
+
+ static void Rebase(const sscpu_timestamp_t timestamp)
+ {
+  for(unsigned i = SS_EVENT__SYNFIRST + 1; i < SS_EVENT__SYNLAST; i++)
+  {
+   if(events[i].event_time != SS_EVENT_DISABLED_TS)
+    events[i].event_time -= timestamp;
+  }
+
+  EventHeap_Rebuild();
+  next_event_ts = EventHeap_Top()->event_time;
+ }
+}
+
+//
+// The scheduler as it was before events.inc, for comparison.
+//
+namespace ListSched
+{
+ struct entry
+ {
+  sscpu_timestamp_t event_time;
+  entry* prev;
+  entry* next;
+ };
+
+ static sscpu_timestamp_t next_event_ts;
+ static entry events[SS_EVENT__COUNT];
+
+ static void Init(void)
+ {
+  for(unsigned i = 0; i < SS_EVENT__COUNT; i++)
+  {
+   events[i].event_time = (i == SS_EVENT__SYNLAST) ? 0x7FFFFFFF : 0;
+   events[i].prev = (i > 0) ? &events[i - 1] : NULL;
+   events[i].next = (i < (SS_EVENT__COUNT - 1)) ? &events[i + 1] : NULL;
+  }
+
+  next_event_ts = events[SS_EVENT__SYNFIRST].next->event_time;
+ }
+
+ static NO_INLINE void Set(unsigned which, const sscpu_timestamp_t next_timestamp)
+ {
+  entry* e = &events[which];
+
+  if(next_timestamp < e->event_time)
+  {
+   entry *fe = e;
+
+   do
+   {
+    fe = fe->prev;
+   } while(next_timestamp < fe->event_time);
+
+   e->prev->next = e->next;
+   e->next->prev = e->prev;
+
+   e->prev = fe;
+   e->next = fe->next;
+   fe->next->prev = e;
+   fe->next = e;
+
+   e->event_time = next_timestamp;
+  }
+  else if(next_timestamp > e->event_time)
+  {
+   entry *fe = e;
+
+   do
+   {
+    fe = fe->next;
+   } while(next_timestamp > fe->event_time);
+
+   e->prev->next = e->next;
+   e->next->prev = e->prev;
+
+   e->prev = fe->prev;
+   e->next = fe;
+   fe->prev->next = e;
+   fe->prev = e;
+
+   e->event_time = next_timestamp;
+  }
+
+  next_event_ts = events[SS_EVENT__SYNFIRST].next->event_time;
+ }
+
+ static INLINE sscpu_timestamp_t NextTS(void) { return next_event_ts; }
+ static INLINE unsigned Top(void) { return events[SS_EVENT__SYNFIRST].next - events; }
+ static INLINE sscpu_timestamp_t Time(unsigned which) { return events[which].event_time; }
+
+ static void Rebase(const sscpu_timestamp_t timestamp)
+ {
+  for(unsigned i = SS_EVENT__SYNFIRST + 1; i < SS_EVENT__SYNLAST; i++)
+  {
+   if(events[i].event_time != SS_EVENT_DISABLED_TS)
+    events[i].event_time -= timestamp;
+  }
+
+  next_event_ts = events[SS_EVENT__SYNFIRST].next->event_time;
+ }
+}
+
+#define SCHED_OPS(ns)											\
+ struct ns##Ops													\
+ {														\
+  static INLINE void Init(void) { ns::Init(); }								\
+  static INLINE void Set(unsigned which, sscpu_timestamp_t ts) { ns::Set(which, ts); }				\
+  static INLINE sscpu_timestamp_t NextTS(void) { return ns::NextTS(); }						\
+  static INLINE unsigned Top(void) { return ns::Top(); }							\
+  static INLINE sscpu_timestamp_t Time(unsigned which) { return ns::Time(which); }				\
+  static INLINE void Rebase(sscpu_timestamp_t timestamp) { ns::Rebase(timestamp); }				\
+ };
+
+SCHED_OPS(HeapSched)
+SCHED_OPS(ListSched)
+#undef SCHED_OPS
+
+//
+// Every event reschedules itself a short, random distance ahead on a coarse time grid(so that same-time events are
+// common), sometimes disables itself, and sometimes pokes another event, similar to how VDP2 schedules MIDSYNC or SCU
+// register writes kick DMA.
+//
+template<typename S>
+static uint32 RunWorkload(const uint64 count)
+{
+ uint32 lcg = 0x12345678;
+ uint32 hash = 2166136261U;
+ sscpu_timestamp_t timestamp = 0;
+
+ S::Init();
+
+ for(uint64 n = 0; n < count; )
+ {
+  timestamp = S::NextTS();
+
+  while(timestamp >= S::Time(S::Top()))
+  {
+   const unsigned which = S::Top();
+   const sscpu_timestamp_t et = S::Time(which);
+   sscpu_timestamp_t nt;
+
+   hash = (hash ^ which ^ ((uint32)et << 4)) * 16777619U;
+   lcg = lcg * 1103515245 + 12345;
+
+   const uint32 r = lcg >> 8;
+
+   if((r & 0x7) == 0)
+   {
+    const unsigned other = SS_EVENT__SYNFIRST + 1 + ((r >> 3) % (SS_EVENT__SYNLAST - SS_EVENT__SYNFIRST - 1));
+
+    if(other != which)
+     S::Set(other, et + ((r >> 7) & 0x3) * 8);
+   }
+
+   if((r & 0x3F) == 0x01)
+    nt = SS_EVENT_DISABLED_TS;
+   else
+    nt = et + 8 + ((r >> 12) & 0x1F) * 8;
+
+   S::Set(which, nt);
+   n++;
+  }
+
+  if(timestamp >= 0x10000000)
+   S::Rebase(timestamp);
+ }
+
+ return hash;
+}
+
+template<typename S>
+static double TimeRun(const uint64 count, uint32* hash)
+{
+ const auto start = std::chrono::steady_clock::now();
+ *hash = RunWorkload<S>(count);
+ const auto end = std::chrono::steady_clock::now();
+
+ return std::chrono::duration<double>(end - start).count();
+}
+
+static void Report(const char* name, const uint64 count, std::vector<double>& secs, const uint32 hash)
+{
+ std::sort(secs.begin(), secs.end());
+
+ const double median = secs[secs.size() / 2];
+
+ printf("%-12s %10.2f Mevents/s median  (%.2f...%.2f over %u runs, order hash 0x%08x)\n", name, count / median / 1000000.0,
+	count / secs.back() / 1000000.0, count / secs.front() / 1000000.0, (unsigned)secs.size(), hash);
+}
+
+//
+// Usage: event_sched [events per run] [runs]
+//
+// Runs alternate between the two schedulers, so that frequency scaling and other machine noise hit both alike, and
+// the median is reported along with the slowest and fastest run.
+//
+int main(int argc, char* argv[])
+{
+ const uint64 count = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000;
+ const unsigned runs = std::max<unsigned>(1, (argc > 2) ? strtoul(argv[2], NULL, 10) : 15);
+ std::vector<double> list_secs, heap_secs;
+ uint32 list_hash = 0, heap_hash = 0;
+
+ for(unsigned i = 0; i < runs; i++)
+ {
+  list_secs.push_back(TimeRun<ListSchedOps>(count, &list_hash));
+  heap_secs.push_back(TimeRun<HeapSchedOps>(count, &heap_hash));
+ }
+
+ Report("linked list", count, list_secs, list_hash);
+ Report("binary heap", count, heap_secs, heap_hash);
+
+ if(list_hash != heap_hash)
+ {
+  printf("Event dispatch order differs!\n");
+  return 1;
+ }
+
+ return 0;
+}
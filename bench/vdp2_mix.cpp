@@ -0,0 +1,162 @@
+/******************************************************************************/
+/* Mednafen Sega Saturn Emulation Module                                      */
+/******************************************************************************/
+/* vdp2_mix.cpp - VDP2 mix kernel microbenchmark
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+//
+// Runs random lines through each MixFinish() variant in mednafen/ss/vdp2_mix.inc that the host CPU supports, checks
+// that their output is bit-for-bit identical to the scalar variant's, and reports pixels per second for each.
+//
+// Build and run with "make bench-vdp2-mix".  Random lines reach flag combinations real content rarely does; to check
+// the variants against each other on frames the core actually renders, run
+// "make bench-vdp2-mix-frames BENCH_ARGS='...'" with core_bench's arguments.
+//
+
+#include "mednafen/ss/ss.h"
+#include "mednafen/ss/vdp2_pixfmt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+
+#include "mednafen/ss/vdp2_mix.inc"
+
+enum : unsigned { NUM_LINES = 64 };
+enum : unsigned { LINE_WIDTH = 704 };
+
+static uint64 Pix[NUM_LINES][LINE_WIDTH];
+static uint32 SecRGB[NUM_LINES][LINE_WIDTH];
+static int32 COffs[NUM_LINES][2][3];
+
+static uint32 lcg = 0x12345678;
+
+static uint32 Rand32(void)
+{
+ uint32 ret;
+
+ lcg = lcg * 1103515245 + 12345;
+ ret = lcg >> 16;
+ lcg = lcg * 1103515245 + 12345;
+ ret |= lcg & 0xFFFF0000;
+
+ return ret;
+}
+
+static void MakeLines(void)
+{
+ for(unsigned l = 0; l < NUM_LINES; l++)
+ {
+  for(unsigned sel = 0; sel < 2; sel++)
+   for(unsigned c = 0; c < 3; c++)
+    COffs[l][sel][c] = (int32)((Rand32() & 0x1FF) - 0x100) * (1 << (c << 3));
+
+  for(unsigned i = 0; i < LINE_WIDTH; i++)
+  {
+   uint64 pix = ((uint64)Rand32() << 32) | Rand32();
+
+   pix &= ~(0xE0ULL << PIX_CCRATIO_SHIFT);	// Ratio is 5 bits.
+
+   Pix[l][i] = pix;
+   SecRGB[l][i] = Rand32();
+  }
+ }
+}
+
+static void Check(const char* name, MixFinishFunc func)
+{
+ static uint32 ref[LINE_WIDTH], out[LINE_WIDTH];
+ static const unsigned widths[] = { 320, 352, 640, 704, 1, 5, 13, 331 };
+
+ for(unsigned ccmd = 0; ccmd < 2; ccmd++)
+ {
+  for(unsigned wi = 0; wi < sizeof(widths) / sizeof(widths[0]); wi++)
+  {
+   const unsigned w = widths[wi];
+
+   for(unsigned l = 0; l < NUM_LINES; l++)
+   {
+    MixFinish_Scalar(ref, w, Pix[l], SecRGB[l], COffs[l], ccmd);
+    func(out, w, Pix[l], SecRGB[l], COffs[l], ccmd);
+
+    if(memcmp(ref, out, w * sizeof(uint32)))
+    {
+     for(unsigned i = 0; i < w; i++)
+     {
+      if(ref[i] != out[i])
+      {
+       printf("%s: mismatch with ccmd=%u w=%u line=%u x=%u: pix=0x%016llx sec=0x%08x, 0x%08x != 0x%08x\n", name, ccmd, w, l, i, (unsigned long long)Pix[l][i], SecRGB[l][i], out[i], ref[i]);
+       break;
+      }
+     }
+     exit(1);
+    }
+   }
+  }
+ }
+}
+
+static void Bench(const char* name, MixFinishFunc func, const unsigned frames)
+{
+ static uint32 out[LINE_WIDTH];
+ uint32 hash = 0;
+ const auto start = std::chrono::steady_clock::now();
+
+ for(unsigned f = 0; f < frames; f++)
+ {
+  for(unsigned l = 0; l < NUM_LINES; l++)
+  {
+   func(out, LINE_WIDTH, Pix[l], SecRGB[l], COffs[l], f & 1);
+   hash += out[l];
+  }
+ }
+
+ const auto end = std::chrono::steady_clock::now();
+ const double secs = std::chrono::duration<double>(end - start).count();
+
+ printf("%-8s %10.2f Mpixels/s  (%.3f s, 0x%08x)\n", name, (double)frames * NUM_LINES * LINE_WIDTH / secs / 1000000.0, secs, hash);
+}
+
+int main(int argc, char* argv[])
+{
+ const unsigned frames = (argc > 1) ? strtoul(argv[1], NULL, 10) : 2000;
+ static const char* const variants[] = { "scalar", "sse2", "avx2" };
+ const MixFinishFunc selected = MixFinish_Select();
+
+ MakeLines();
+
+ for(const char* name : variants)
+ {
+  const MixFinishFunc func = MixFinish_Get(name);
+
+  if(!func)
+  {
+   printf("%-8s not available on this host\n", name);
+   continue;
+  }
+
+  Check(name, func);
+  Bench(name, func, frames);
+
+  if(func == selected)
+   printf("selected: %s\n", name);
+ }
+
+ return 0;
+}
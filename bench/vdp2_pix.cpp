@@ -0,0 +1,243 @@
+/******************************************************************************/
+/* Mednafen Sega Saturn Emulation Module                                      */
+/******************************************************************************/
+/* vdp2_pix.cpp - VDP2 NBG/RBG pixel conversion check and microbenchmark
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+//
+// Runs random tile rows through MakeNBGRBGPixRow() in mednafen/ss/vdp2_pix.inc, for every color mode, transparency,
+// priority and color calculation mode combination T_DrawNBG() is instantiated with, checks that its output is
+// bit-for-bit identical to 8 MakeNBGRBGPix() calls, and reports dots per second for both, along with which of the two
+// NBGRBGPixRowFaster() has the renderer use.
+//
+// Build and run with "make bench-vdp2-pix".
+//
+
+#include "mednafen/ss/ss.h"
+#include "mednafen/ss/vdp2_pixfmt.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+static uint32 ColorCache[2048];
+
+#include "mednafen/ss/vdp2_pix.inc"
+
+// Stand-in for vdp2_render.cpp's TileFetcher, holding what Fetch() leaves for the pixel functions.
+struct FakeTileFetcher
+{
+ uint32 pcco;
+ bool spr;
+ bool scc;
+ const uint16* tile_vrb;
+ uint32 cellx_xor;
+};
+
+enum : unsigned { NUM_ROWS = 4096 };
+
+struct RowSetup
+{
+ uint16 vrb[16];	// Enough for one 32bpp tile row.
+ uint32 pcco;
+ bool spr;
+ bool scc;
+ uint32 tile_x;
+ bool hflip;
+ uint32 pix_base_or;
+ int16 sfcode_lut[8];
+};
+
+static RowSetup Rows[NUM_ROWS];
+
+static uint32 lcg = 0x12345678;
+
+static uint32 Rand32(void)
+{
+ uint32 ret;
+
+ lcg = lcg * 1103515245 + 12345;
+ ret = lcg >> 16;
+ lcg = lcg * 1103515245 + 12345;
+ ret |= lcg & 0xFFFF0000;
+
+ return ret;
+}
+
+static void MakeRows(void)
+{
+ for(unsigned i = 0; i < 2048; i++)
+  ColorCache[i] = Rand32();
+
+ for(unsigned r = 0; r < NUM_ROWS; r++)
+ {
+  RowSetup* rs = &Rows[r];
+
+  for(unsigned i = 0; i < 16; i++)
+  {
+   uint16 v = Rand32();
+
+   // Make fully transparent dots, of each size, common enough to matter.
+   if(!(Rand32() & 3))
+    v &= (Rand32() & 1) ? 0x7800 : 0x0F0F;
+
+   rs->vrb[i] = v;
+  }
+
+  rs->pcco = Rand32() & 0x7FF;
+  rs->spr = Rand32() & 1;
+  rs->scc = Rand32() & 1;
+  rs->tile_x = Rand32() & 0x1FF;
+  rs->hflip = Rand32() & 1;
+  rs->pix_base_or = Rand32();
+
+  for(unsigned i = 0; i < 8; i++)
+  {
+   uint16 tmp = 0xFFFF;
+
+   if(Rand32() & 1)
+    tmp &= ~(1U << PIX_PRIO_SHIFT);
+
+   if(Rand32() & 1)
+    tmp &= ~(1U << PIX_CCE_SHIFT);
+
+   rs->sfcode_lut[i] = tmp;
+  }
+ }
+}
+
+static INLINE void SetupFetcher(FakeTileFetcher* tf, const RowSetup* rs)
+{
+ tf->pcco = rs->pcco;
+ tf->spr = rs->spr;
+ tf->scc = rs->scc;
+ tf->tile_vrb = rs->vrb;
+ tf->cellx_xor = (rs->tile_x << 3) | (rs->hflip ? 0x7 : 0x0);
+}
+
+template<unsigned TA_bpp, bool TA_isrgb, bool TA_igntp, unsigned TA_PrioMode, unsigned TA_CCMode>
+static void Check(const char* name)
+{
+ uint64 ref[8], out[8];
+ FakeTileFetcher tf;
+
+ for(unsigned r = 0; r < NUM_ROWS; r++)
+ {
+  const RowSetup* rs = &Rows[r];
+
+  SetupFetcher(&tf, rs);
+
+  for(unsigned k = 0; k < 8; k++)
+   ref[k] = MakeNBGRBGPix<false, TA_bpp, TA_isrgb, TA_igntp, TA_PrioMode, TA_CCMode>(tf, rs->pix_base_or, rs->sfcode_lut, (rs->tile_x << 3) + k, 0);
+
+  MakeNBGRBGPixRow<TA_bpp, TA_isrgb, TA_igntp, TA_PrioMode, TA_CCMode>(tf, rs->pix_base_or, rs->sfcode_lut, out);
+
+  for(unsigned k = 0; k < 8; k++)
+  {
+   if(ref[k] != out[k])
+   {
+    printf("%s igntp=%u prio=%u cc=%u: mismatch at row=%u dot=%u hflip=%u: 0x%016llx != 0x%016llx\n", name, TA_igntp, TA_PrioMode, TA_CCMode, r, k, rs->hflip, (unsigned long long)out[k], (unsigned long long)ref[k]);
+    exit(1);
+   }
+  }
+ }
+}
+
+template<unsigned TA_bpp, bool TA_isrgb, bool TA_igntp>
+static void CheckModes(const char* name)
+{
+ Check<TA_bpp, TA_isrgb, TA_igntp, 0, 0>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 0, 1>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 0, 2>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 0, 3>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 1, 0>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 1, 1>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 1, 2>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 1, 3>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 2, 0>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 2, 1>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 2, 2>(name);
+ Check<TA_bpp, TA_isrgb, TA_igntp, 2, 3>(name);
+}
+
+template<unsigned TA_bpp, bool TA_isrgb>
+static void Bench(const char* name, const unsigned passes)
+{
+ static uint64 out[8];
+ FakeTileFetcher tf;
+ uint64 hash[2] = { 0, 0 };
+ double secs[2];
+
+ for(unsigned which = 0; which < 2; which++)
+ {
+  const auto start = std::chrono::steady_clock::now();
+
+  for(unsigned p = 0; p < passes; p++)
+  {
+   for(unsigned r = 0; r < NUM_ROWS; r++)
+   {
+    const RowSetup* rs = &Rows[r];
+
+    SetupFetcher(&tf, rs);
+
+    if(which)
+     MakeNBGRBGPixRow<TA_bpp, TA_isrgb, false, 2, 2>(tf, rs->pix_base_or, rs->sfcode_lut, out);
+    else
+    {
+     for(unsigned k = 0; k < 8; k++)
+      out[k] = MakeNBGRBGPix<false, TA_bpp, TA_isrgb, false, 2, 2>(tf, rs->pix_base_or, rs->sfcode_lut, (rs->tile_x << 3) + k, 0);
+    }
+
+    hash[which] += out[r & 7];
+   }
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+
+  secs[which] = std::chrono::duration<double>(end - start).count();
+ }
+
+ printf("%-8s %10.2f Mdots/s per-dot, %10.2f Mdots/s row, uses %-7s (0x%016llx)\n", name, (double)passes * NUM_ROWS * 8 / secs[0] / 1000000.0, (double)passes * NUM_ROWS * 8 / secs[1] / 1000000.0, NBGRBGPixRowFaster(TA_bpp, TA_isrgb) ? "row" : "per-dot", (unsigned long long)(hash[0] ^ hash[1]));
+}
+
+int main(int argc, char* argv[])
+{
+ const unsigned passes = (argc > 1) ? strtoul(argv[1], NULL, 10) : 2000;
+
+ MakeRows();
+
+ CheckModes< 4, false, false>("4bpp");
+ CheckModes< 4, false,  true>("4bpp");
+ CheckModes< 8, false, false>("8bpp");
+ CheckModes< 8, false,  true>("8bpp");
+ CheckModes<16, false, false>("16bpp");
+ CheckModes<16, false,  true>("16bpp");
+ CheckModes<16,  true, false>("rgb15");
+ CheckModes<16,  true,  true>("rgb15");
+ CheckModes<32,  true, false>("rgb24");
+ CheckModes<32,  true,  true>("rgb24");
+ printf("MakeNBGRBGPixRow() matches MakeNBGRBGPix() for %u random rows in all modes.\n", NUM_ROWS);
+
+ Bench< 4, false>("4bpp", passes);
+ Bench< 8, false>("8bpp", passes);
+ Bench<16, false>("16bpp", passes);
+ Bench<16,  true>("rgb15", passes);
+ Bench<32,  true>("rgb24", passes);
+
+ return 0;
+}
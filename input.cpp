@@ -482,11 +482,21 @@ void input_init_env( retro_environment_t _environ_cb )
 		RETRO_DESCRIPTOR_BLOCK( 10 ),
 		RETRO_DESCRIPTOR_BLOCK( 11 ),
 
+		{ 0, RETRO_DEVICE_JOYPAD, 0, RETRO_DEVICE_ID_JOYPAD_L3, "Rewind (Core Option)" },
+
 		{ 0 },
 	};
 
 #undef RETRO_DESCRIPTOR_BLOCK
 
+	/* The rewind button is chosen with a core option, and there's none by default. */
+	struct retro_input_descriptor* rewind_desc = &desc[ ( sizeof( desc ) / sizeof( desc[ 0 ] ) ) - 2 ];
+
+	if ( setting_rewind_button >= 0 )
+		rewind_desc->id = setting_rewind_button;
+	else
+		memset( rewind_desc, 0, sizeof( *rewind_desc ) );
+
 	/* Send to front-end */
 	environ_cb( RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, desc );
 }
@@ -1294,6 +1304,8 @@ void retro_set_controller_port_device( unsigned in_port, unsigned device )
 
 		}; // switch ( device )
 
+		SS_InvalidateStateSize();
+
 	}; // valid port?
 }
 
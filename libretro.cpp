@@ -33,6 +33,7 @@ static INLINE bool DBG_NeedCPUHooks(void) { return false; } // <-- replaces debu
 #include <time.h>
 
 #include <bitset>
+#include <chrono>
 
 struct retro_perf_callback perf_cb;
 retro_get_cpu_features_t perf_get_cpu_features_cb = NULL;
@@ -115,11 +116,14 @@ MDFNGI *MDFNGameInfo = NULL;
 
 #include "mednafen/ss/ss.h"
 #include "mednafen/ss/sound.h"
+#include "mednafen/sound/PolyphaseResampler.h"
+#include "mednafen/state_rewind.h"
 #include "mednafen/ss/scsp.h"
 #include "mednafen/ss/smpc.h"
 #include "mednafen/ss/cdb.h"
 #include "mednafen/ss/vdp1.h"
 #include "mednafen/ss/vdp2.h"
+#include "mednafen/ss/vdp2_render.h"
 #include "mednafen/ss/scu.h"
 #include "mednafen/ss/cart.h"
 #include "mednafen/ss/db.h"
@@ -155,6 +159,7 @@ static uint8 WorkRAM[2*WORKRAM_BANK_SIZE_BYTES]; // unified 2MB work ram for lin
 // Effectively 32-bit in reality, but 16-bit here because of CPU interpreter design(regarding fastmap).
 static uint16* WorkRAML = (uint16*)(WorkRAM + (WORKRAM_BANK_SIZE_BYTES*0));
 static uint16* WorkRAMH = (uint16*)(WorkRAM + (WORKRAM_BANK_SIZE_BYTES*1));
+static uint8 WorkRAM_Dirty[2][WORKRAM_BANK_SIZE_BYTES >> SS_PAGE_SHIFT];	// For the rewind ring; see mednafen/state.h
 static uint8 BackupRAM[32768];
 static bool BackupRAM_Dirty;
 static int64 BackupRAM_SaveDelay;
@@ -166,6 +171,40 @@ static uintptr_t SH7095_FastMap[1U << (32 - SH7095_EXT_MAP_GRAN_BITS)];
 int32 SH7095_mem_timestamp;
 uint32 SH7095_BusLock;
 static uint32 SH7095_DB;
+static sscpu_timestamp_t next_event_ts;
+
+//
+// Returns true if a read from SH-2 address "A" has no side effects, and can only return a different value
+// after an event, an interrupt, or a write by the other CPU; used by SH-2 idle loop detection.
+//
+// SH7095_IdleLoopMemReadOK() is the subset of those addresses that are in BIOS ROM or work RAM, and so can be read
+// through SH7095_FastMap.
+//
+static INLINE bool SH7095_IdleLoopMemReadOK(uint32 A)
+{
+ if((A >> 29) > 1)
+  return false;
+
+ A &= 0x07FFFFFF;
+
+ return (A < 0x00100000)				// BIOS ROM
+	|| (A >= 0x00200000 && A < 0x00400000)	// Low work RAM
+	|| (A >= 0x06000000);				// High work RAM
+}
+
+static INLINE bool SH7095_IdleLoopReadOK(uint32 A)
+{
+ if(SH7095_IdleLoopMemReadOK(A))
+  return true;
+
+ if((A >> 29) > 1)
+  return false;
+
+ A &= 0x07FFFFFF;
+
+ return ((A & ~1U) == 0x00100062)			// SMPC SF
+	|| ((A & ~3U) == 0x05FE00A4);			// SCU IST
+}
 
 #include "mednafen/ss/scu.inc"
 
@@ -223,7 +262,10 @@ static INLINE void BusRW_DB_CS0(const uint32 A, uint32& DB, const bool BurstHax,
  if(A >= 0x00200000 && A <= 0x003FFFFF)
  {
   if(IsWrite)
+  {
    ne16_wbo_be<T>(WorkRAML, A & 0xFFFFF, DB >> (((A & 1) ^ (2 - sizeof(T))) << 3));
+   SS_MarkDirty(WorkRAM_Dirty[0], A & 0xFFFFF);
+  }
   else
    DB = (DB & 0xFFFF0000) | ne16_rbo_be<uint16>(WorkRAML, A & 0xFFFFE);
 
@@ -352,6 +394,9 @@ static INLINE void BusRW_DB_CS123(const uint32 A, uint32& DB, const bool BurstHa
   else
    ne16_wbo_be<T>(WorkRAMH, A & 0xFFFFF, DB >> (((A & 3) ^ (4 - sizeof(T))) << 3));
 
+  if(IsWrite)
+   SS_MarkDirty(WorkRAM_Dirty[1], A & 0xFFFFF);
+
   if(!BurstHax)
   {
    if(!SH2DMAHax)
@@ -483,6 +528,7 @@ static MDFN_COLD void CheatMemWrite(uint32 A, uint8 V)
  if(FMIsWriteable[A >> SH7095_EXT_MAP_GRAN_BITS])
  {
   ne16_wbo_be<uint8>(SH7095_FastMap[A >> SH7095_EXT_MAP_GRAN_BITS], A, V);
+  MDFNSS_MarkDirtyAt((uint8*)(SH7095_FastMap[A >> SH7095_EXT_MAP_GRAN_BITS] + A));
 
   for(unsigned c = 0; c < 2; c++)
   {
@@ -557,7 +603,7 @@ void SS_SetPhysMemMap(uint32 Astart, uint32 Aend, uint16* ptr, uint32 length, bo
 static bool Running;
 event_list_entry events[SS_EVENT__COUNT];
 
-static sscpu_timestamp_t next_event_ts;
+#include "mednafen/ss/events.inc"
 
 template<unsigned c>
 static sscpu_timestamp_t SH_DMA_EventHandler(sscpu_timestamp_t et)
@@ -586,9 +632,6 @@ static MDFN_COLD void InitEvents(void)
    events[i].event_time = 0x7FFFFFFF;
   else
    events[i].event_time = 0; //SS_EVENT_DISABLED_TS;
-
-  events[i].prev = (i > 0) ? &events[i - 1] : NULL;
-  events[i].next = (i < (SS_EVENT__COUNT - 1)) ? &events[i + 1] : NULL;
  }
 
  events[SS_EVENT_SH2_M_DMA].event_handler = &SH_DMA_EventHandler<0>;
@@ -610,6 +653,8 @@ static MDFN_COLD void InitEvents(void)
 
  events[SS_EVENT_MIDSYNC].event_handler = MidSync;
  events[SS_EVENT_MIDSYNC].event_time = SS_EVENT_DISABLED_TS;
+
+ EventHeap_Init();
 }
 
 static void RebaseTS(const sscpu_timestamp_t timestamp)
@@ -625,55 +670,34 @@ static void RebaseTS(const sscpu_timestamp_t timestamp)
    events[i].event_time -= timestamp;
  }
 
- next_event_ts = events[SS_EVENT__SYNFIRST].next->event_time;
+ EventHeap_Rebuild();
+ next_event_ts = EventHeap_Top()->event_time;
 }
 
-void SS_SetEventNT(event_list_entry* e, const sscpu_timestamp_t next_timestamp)
-{
- if(next_timestamp < e->event_time)
- {
-  event_list_entry *fe = e;
-
-  do
-  {
-   fe = fe->prev;
-  } while(next_timestamp < fe->event_time);
+bool SS_ProfileActive = false;
+SS_ProfileData SS_Profile;
 
-  // Remove this event from the list, temporarily of course.
-  e->prev->next = e->next;
-  e->next->prev = e->prev;
-
-  // Insert into the list, just after "fe".
-  e->prev = fe;
-  e->next = fe->next;
-  fe->next->prev = e;
-  fe->next = e;
-
-  e->event_time = next_timestamp;
- }
- else if(next_timestamp > e->event_time)
- {
-  event_list_entry *fe = e;
+static INLINE uint64 ProfileClockNS(void)
+{
+ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
 
-  do
-  {
-   fe = fe->next;
-  } while(next_timestamp > fe->event_time);
+static NO_INLINE sscpu_timestamp_t CallEventHandler_Profiled(event_list_entry* e, const sscpu_timestamp_t timestamp)
+{
+ const uint64 start_time = ProfileClockNS();
+ const sscpu_timestamp_t ret = e->event_handler(timestamp);
 
-  // Remove this event from the list, temporarily of course
-  e->prev->next = e->next;
-  e->next->prev = e->prev;
+ SS_Profile.event_ns[e - events] += ProfileClockNS() - start_time;
 
-  // Insert into the list, just BEFORE "fe".
-  e->prev = fe->prev;
-  e->next = fe;
-  fe->prev->next = e;
-  fe->prev = e;
+ return ret;
+}
 
-  e->event_time = next_timestamp;
- }
+static INLINE sscpu_timestamp_t CallEventHandler(event_list_entry* e, const sscpu_timestamp_t timestamp)
+{
+ if(MDFN_UNLIKELY(SS_ProfileActive))
+  return CallEventHandler_Profiled(e, timestamp);
 
- next_event_ts = (Running ? events[SS_EVENT__SYNFIRST].next->event_time : 0);
+ return e->event_handler(timestamp);
 }
 
 // Called from debug.cpp too.
@@ -687,20 +711,20 @@ void ForceEventUpdates(const sscpu_timestamp_t timestamp)
  for(unsigned evnum = SS_EVENT__SYNFIRST + 1; evnum < SS_EVENT__SYNLAST; evnum++)
  {
   if(events[evnum].event_time != SS_EVENT_DISABLED_TS)
-   SS_SetEventNT(&events[evnum], events[evnum].event_handler(timestamp));
+   SS_SetEventNT(&events[evnum], CallEventHandler(&events[evnum], timestamp));
  }
 
- next_event_ts = (Running ? events[SS_EVENT__SYNFIRST].next->event_time : 0);
+ next_event_ts = (Running ? EventHeap_Top()->event_time : 0);
 }
 
 static INLINE bool EventHandler(const sscpu_timestamp_t timestamp)
 {
  event_list_entry *e = NULL;
 
- while(timestamp >= (e = events[SS_EVENT__SYNFIRST].next)->event_time)  // If Running = 0, EventHandler() may be called even if there isn't an event per-se, so while() instead of do { ... } while
+ while(timestamp >= (e = EventHeap_Top())->event_time)  // If Running = 0, EventHandler() may be called even if there isn't an event per-se, so while() instead of do { ... } while
  {
   sscpu_timestamp_t nt;
-  nt = e->event_handler(e->event_time);
+  nt = CallEventHandler(e, e->event_time);
 
   SS_SetEventNT(e, nt);
  }
@@ -972,7 +996,84 @@ typedef struct
 
 uint32 ss_horrible_hacks;
 
-static bool InitCommon(const unsigned cpucache_emumode, const unsigned cart_type, const unsigned smpc_area, const uint32 horrible_hacks )
+static unsigned IdleSkipDB;
+static int RewindDepth;	// Depth the rewind ring is running with, 0 if it isn't.
+
+static void UpdateVDP2WaitMode(void)
+{
+   switch (setting_vdp2_wait_mode)
+   {
+      case SETTING_VDP2_WAIT_SPIN_SLEEP:
+         VDP2REND_SetWaitMode(VDP2REND_WAIT_SPIN_PARK);
+         break;
+      case SETTING_VDP2_WAIT_SLEEP:
+         VDP2REND_SetWaitMode(VDP2REND_WAIT_BLOCK);
+         break;
+      default:
+         VDP2REND_SetWaitMode(VDP2REND_WAIT_BUSY);
+         break;
+   }
+}
+
+static void LogVDP2WaitStats(void)
+{
+   VDP2Rend_WaitStats ws;
+
+   VDP2REND_GetWaitStats(&ws);
+
+   if (!ws.depth_samples)
+      return;
+
+   log_cb(RETRO_LOG_INFO, "[Mednafen]: VDP2 render thread: spun %.3f s, slept %.3f s (%llu times); frame end waits %.3f s; queue depth avg %.1f, max %u.\n",
+         ws.spin_ns / 1e9, ws.park_ns / 1e9, (unsigned long long)ws.parks, ws.frame_wait_ns / 1e9,
+         ws.depth_samples ? (double)ws.depth_sum / ws.depth_samples : 0.0, ws.depth_max);
+}
+
+static void LogVDP1DrawThreadStats(void)
+{
+   VDP1::DrawThreadStats dts;
+
+   VDP1::GetDrawThreadStats(&dts);
+
+   if (!dts.lines)
+      return;
+
+   log_cb(RETRO_LOG_INFO, "[Mednafen]: VDP1 draw thread: %llu lines; waited for it %llu times, %.3f s total.\n",
+         (unsigned long long)dts.lines, (unsigned long long)dts.syncs, dts.sync_wait_ns / 1e9);
+}
+
+// The rewind ring only runs while there's a button to rewind with.
+static void UpdateRewind(void)
+{
+   const int depth = (setting_rewind_button >= 0 && setting_rewind_depth > 0) ? setting_rewind_depth : 0;
+
+   if (depth == RewindDepth)
+      return;
+
+   if (depth > 0)
+      MDFN_StateEvilBegin(depth);
+   else
+      MDFN_StateEvilEnd();
+
+   RewindDepth = depth;
+}
+
+static void UpdateIdleSkip(void)
+{
+   bool enable;
+
+   if (setting_sh2_idleskip == SETTING_SH2_IDLESKIP_ENABLED)
+      enable = (IdleSkipDB != IDLESKIP_DENY);
+   else if (setting_sh2_idleskip == SETTING_SH2_IDLESKIP_ALLOWLISTED)
+      enable = (IdleSkipDB == IDLESKIP_ALLOW);
+   else
+      enable = false;
+
+   for(unsigned i = 0; i < 2; i++)
+      CPU[i].IdleSkip = enable;
+}
+
+static bool InitCommon(const unsigned cpucache_emumode, const unsigned cart_type, const unsigned smpc_area, const uint32 horrible_hacks, const unsigned idleskip )
 {
  //
 
@@ -1043,6 +1144,9 @@ static bool InitCommon(const unsigned cpucache_emumode, const unsigned cart_type
 
    ss_horrible_hacks = horrible_hacks;
 
+   IdleSkipDB = idleskip;
+   UpdateIdleSkip();
+
    //
    // Initialize backup memory.
    //
@@ -1057,6 +1161,8 @@ static bool InitCommon(const unsigned cpucache_emumode, const unsigned cart_type
    SS_SetPhysMemMap(0x06000000, 0x07FFFFFF, WorkRAMH, WORKRAM_BANK_SIZE_BYTES, true);
    MDFNMP_RegSearchable(0x00200000, WORKRAM_BANK_SIZE_BYTES);
    MDFNMP_RegSearchable(0x06000000, WORKRAM_BANK_SIZE_BYTES);
+   MDFNSS_TrackDirty(WorkRAML, WORKRAM_BANK_SIZE_BYTES, WorkRAM_Dirty[0]);
+   MDFNSS_TrackDirty(WorkRAMH, WORKRAM_BANK_SIZE_BYTES, WorkRAM_Dirty[1]);
 
    CART_Init(cart_type);
 
@@ -1113,8 +1219,11 @@ static bool InitCommon(const unsigned cpucache_emumode, const unsigned cart_type
    SCU_Init();
    SMPC_Init(smpc_area, MasterClock);
    VDP1::Init();
+   VDP1::SetDrawThread(setting_vdp1_thread);
    VDP2::Init(PAL);
    VDP2::SetGetVideoParams(&EmulatedSS, true, sls, sle, true, DoHBlend);
+   VDP2::SetMixThreads(setting_vdp2_mix_threads);
+   UpdateVDP2WaitMode();
    CDB_Init();
    SOUND_Init();
 
@@ -1185,6 +1294,9 @@ static MDFN_COLD void CloseGame(void)
  SaveCartNV();
  SaveRTC();
 
+ LogVDP1DrawThreadStats();
+ LogVDP2WaitStats();
+
  Cleanup();
 }
 
@@ -1326,21 +1438,28 @@ struct EventsPacker
 
 INLINE void EventsPacker::Save(void)
 {
- event_list_entry* evt = events[SS_EVENT__SYNFIRST].next;
+ event_list_entry* evt[eventcopy_bound - eventcopy_first];
 
  for(size_t i = eventcopy_first; i < eventcopy_bound; i++)
  {
   event_times[i - eventcopy_first] = events[i].event_time;
-  event_order[i - eventcopy_first] = evt - events;
+  evt[i - eventcopy_first] = &events[i];
+ }
+
+ std::sort(evt, evt + (eventcopy_bound - eventcopy_first), EventBefore);
+
+ for(size_t i = eventcopy_first; i < eventcopy_bound; i++)
+ {
+  event_order[i - eventcopy_first] = evt[i - eventcopy_first] - events;
   assert(event_order[i - eventcopy_first] >= eventcopy_first && event_order[i - eventcopy_first] < eventcopy_bound);
-  evt = evt->next;
  }
 }
 
 INLINE bool EventsPacker::Restore(void)
 {
  bool used[SS_EVENT__COUNT] = { 0 };
- event_list_entry* evt = &events[SS_EVENT__SYNFIRST];
+ int32 prev_et = events[SS_EVENT__SYNFIRST].event_time;
+
  for(size_t i = eventcopy_first; i < eventcopy_bound; i++)
  {
   int32 et = event_times[i - eventcopy_first];
@@ -1357,45 +1476,20 @@ INLINE bool EventsPacker::Restore(void)
   if(et < events[SS_EVENT__SYNFIRST].event_time)
    return false;
 
-  events[i].event_time = et;
+  if(event_times[eo - eventcopy_first] < prev_et)
+   return false;
 
-  evt->next = &events[eo];
-  evt->next->prev = evt;
-  evt = evt->next;
+  prev_et = event_times[eo - eventcopy_first];
  }
- evt->next = &events[SS_EVENT__SYNLAST];
- evt->next->prev = evt;
 
- for(size_t i = 0; i < SS_EVENT__COUNT; i++)
- {
-  if(i == SS_EVENT__SYNLAST)
-  {
-   if(events[i].next != NULL)
-    return false;
-  }
-  else
-  {
-   if(events[i].next->prev != &events[i])
-    return false;
+ if(prev_et > events[SS_EVENT__SYNLAST].event_time)
+  return false;
 
-   if(events[i].next->event_time < events[i].event_time)
-    return false;
-  }
-
-  if(i == SS_EVENT__SYNFIRST)
-  {
-   if(events[i].prev != NULL)
-    return false;
-  }
-  else
-  {
-   if(events[i].prev->next != &events[i])
-    return false;
+ for(size_t i = eventcopy_first; i < eventcopy_bound; i++)
+  events[i].event_time = event_times[i - eventcopy_first];
 
-   if(events[i].prev->event_time > events[i].event_time)
-    return false;
-  }
- }
+ EventHeap_SetOrder(event_order, eventcopy_bound - eventcopy_first);
+ EventHeap_Rebuild();
 
  return true;
 }
@@ -1528,6 +1622,7 @@ MDFNGI EmulatedSS =
 //forward decls
 static bool overscan;
 static double last_sound_rate;
+static bool RunAheadFailed;	// A snapshot failed; frames are rendered normally until the run-ahead option changes.
 
 
 #ifdef NEED_DEINTERLACER
@@ -1537,6 +1632,66 @@ static Deinterlacer deint;
 
 static MDFN_Surface *surf = NULL;
 
+#define SOUND_CHANNELS 2
+
+//
+// The SCSP always runs at 44100Hz.  For any other output rate, AudioResampler converts each frame's worth of samples,
+// and with a chunk size set, output is held back in AudioOutBuf and handed to the frontend only in batches of exactly
+// that many frames.
+//
+static PolyphaseResampler* AudioResampler;
+static int16 AudioOutBuf[8192 * SOUND_CHANNELS];
+static uint32 AudioOutCount;
+
+static void UpdateAudioOutput(void)
+{
+   if (AudioResampler)
+   {
+      delete AudioResampler;
+      AudioResampler = NULL;
+   }
+
+   if (setting_audio_rate != 44100)
+      AudioResampler = new PolyphaseResampler(44100, setting_audio_rate);
+
+   AudioOutCount = 0;
+}
+
+static void OutputAudio(int16* samples, uint32 frames)
+{
+   uint32 pos = 0;
+
+   if (!AudioResampler && !setting_audio_chunk)
+   {
+      audio_batch_cb(samples, frames);
+      return;
+   }
+
+   if (AudioResampler)
+      AudioOutCount += AudioResampler->Process(samples, frames, &AudioOutBuf[AudioOutCount * SOUND_CHANNELS]);
+   else
+   {
+      memcpy(&AudioOutBuf[AudioOutCount * SOUND_CHANNELS], samples, frames * SOUND_CHANNELS * sizeof(int16));
+      AudioOutCount += frames;
+   }
+
+   if (!setting_audio_chunk)
+   {
+      audio_batch_cb(AudioOutBuf, AudioOutCount);
+      AudioOutCount = 0;
+      return;
+   }
+
+   while ((AudioOutCount - pos) >= (uint32)setting_audio_chunk)
+   {
+      audio_batch_cb(&AudioOutBuf[pos * SOUND_CHANNELS], setting_audio_chunk);
+      pos += setting_audio_chunk;
+   }
+
+   AudioOutCount -= pos;
+   memmove(AudioOutBuf, &AudioOutBuf[pos * SOUND_CHANNELS], AudioOutCount * SOUND_CHANNELS * sizeof(int16));
+}
+
 static void alloc_surface() {
   MDFN_PixelFormat pix_fmt(MDFN_COLORSPACE_RGB, 16, 8, 0, 24);
   uint32_t width  = MEDNAFEN_CORE_GEOMETRY_MAX_W;
@@ -1622,6 +1777,7 @@ void retro_init(void)
 void retro_reset(void)
 {
    SS_Reset( true );
+   MDFN_StateEvilFlush();
 }
 
 bool retro_load_game_special(unsigned, const struct retro_game_info *, size_t)
@@ -1657,6 +1813,16 @@ static void check_variables(bool startup)
          if (!strcmp(var.value, "enabled"))
             cdimagecache = true;
 
+      var.key = "beetle_saturn_chd_hunk_cache";
+
+      if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+         setting_chd_hunk_cache = atoi(var.value);
+
+      var.key = "beetle_saturn_chd_decode_threads";
+
+      if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+         setting_chd_decode_threads = atoi(var.value);
+
       var.key = "beetle_saturn_shared_int";
 
       if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -1769,6 +1935,149 @@ static void check_variables(bool startup)
          setting_midsync = false;
    }
 
+   var.key = "beetle_saturn_sh2_idleskip";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "enabled"))
+         setting_sh2_idleskip = SETTING_SH2_IDLESKIP_ENABLED;
+      else if (!strcmp(var.value, "allowlisted"))
+         setting_sh2_idleskip = SETTING_SH2_IDLESKIP_ALLOWLISTED;
+      else if (!strcmp(var.value, "disabled"))
+         setting_sh2_idleskip = SETTING_SH2_IDLESKIP_DISABLED;
+
+      if (!startup)
+         UpdateIdleSkip();
+   }
+
+   var.key = "beetle_saturn_vdp1_thread";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      if (!strcmp(var.value, "enabled"))
+         setting_vdp1_thread = true;
+      else if (!strcmp(var.value, "disabled"))
+         setting_vdp1_thread = false;
+
+      if (!startup)
+         VDP1::SetDrawThread(setting_vdp1_thread);
+   }
+
+   var.key = "beetle_saturn_audio_rate";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int newval = atoi(var.value);
+
+      if (newval < 22050)
+         newval = 44100;
+
+      if (startup || newval != setting_audio_rate)
+      {
+         setting_audio_rate = newval;
+         UpdateAudioOutput();
+
+         if (!startup)
+         {
+            struct retro_system_av_info av_info;
+
+            retro_get_system_av_info(&av_info);
+            environ_cb(RETRO_ENVIRONMENT_SET_SYSTEM_AV_INFO, &av_info);
+         }
+      }
+   }
+
+   var.key = "beetle_saturn_audio_chunk";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      setting_audio_chunk = atoi(var.value);
+
+   var.key = "beetle_saturn_rewind_depth";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      setting_rewind_depth = atoi(var.value);
+
+   var.key = "beetle_saturn_rewind_button";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int newval = -1;
+
+      if (!strcmp(var.value, "l3"))
+         newval = RETRO_DEVICE_ID_JOYPAD_L3;
+      else if (!strcmp(var.value, "r3"))
+         newval = RETRO_DEVICE_ID_JOYPAD_R3;
+
+      if (newval != setting_rewind_button)
+      {
+         setting_rewind_button = newval;
+         input_init_env(environ_cb);
+      }
+   }
+
+   UpdateRewind();
+
+   var.key = "beetle_saturn_run_ahead";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int newval = atoi(var.value);
+
+      if (newval != setting_run_ahead)
+      {
+         if (newval <= 0)
+            MDFN_RunAheadEnd();
+
+         RunAheadFailed = false;
+      }
+
+      setting_run_ahead = (newval > 0) ? newval : 0;
+   }
+
+   var.key = "beetle_saturn_state_compression";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      bool newval = !strcmp(var.value, "enabled");
+
+#ifndef HAVE_ZLIB_DEFLATE
+      if (newval && !setting_state_compression)
+         log_cb(RETRO_LOG_WARN, "[Mednafen]: This build can't compress save states(needs SYSTEM_ZLIB=1); storing them uncompressed.\n");
+#endif
+      setting_state_compression = newval;
+   }
+
+   var.key = "beetle_saturn_vdp2_mix_threads";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int newval = atoi(var.value);
+
+      if (!startup && newval != setting_vdp2_mix_threads)
+         VDP2::SetMixThreads(newval);
+
+      setting_vdp2_mix_threads = newval;
+   }
+
+   var.key = "beetle_saturn_vdp2_wait_mode";
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+   {
+      int newval = SETTING_VDP2_WAIT_BUSY;
+
+      if (!strcmp(var.value, "spin_sleep"))
+         newval = SETTING_VDP2_WAIT_SPIN_SLEEP;
+      else if (!strcmp(var.value, "sleep"))
+         newval = SETTING_VDP2_WAIT_SLEEP;
+
+      const bool changed = (newval != setting_vdp2_wait_mode);
+
+      setting_vdp2_wait_mode = newval;
+
+      if (!startup && changed)
+         UpdateVDP2WaitMode();
+   }
+
    var.key = "beetle_saturn_autortc";
 
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
@@ -1892,6 +2201,7 @@ static bool MDFNI_LoadGame( const char *name )
    int cart_type;
    unsigned region;
    uint32 horrible_hacks = 0;
+   unsigned idleskip = IDLESKIP_DEFAULT;
 
    // .. safe defaults
    region = SMPC_AREA_NA;
@@ -1934,7 +2244,7 @@ static bool MDFNI_LoadGame( const char *name )
             {
                disc_detect_region( &region );
 
-               DB_Lookup(nullptr, sgid, fd_id, &region, &cart_type, &cpucache_emumode, &horrible_hacks );
+               DB_Lookup(nullptr, sgid, fd_id, &region, &cart_type, &cpucache_emumode, &horrible_hacks, &idleskip );
 
                // forced region setting?
                if ( setting_region != 0 ) {
@@ -1947,7 +2257,7 @@ static bool MDFNI_LoadGame( const char *name )
                }
 
                // GO!
-               if ( InitCommon( cpucache_emumode, cart_type, region, horrible_hacks ) )
+               if ( InitCommon( cpucache_emumode, cart_type, region, horrible_hacks, idleskip ) )
                {
                   MDFN_LoadGameCheats(NULL);
                   MDFNMP_InstallReadPatches();
@@ -1989,7 +2299,7 @@ static bool MDFNI_LoadGame( const char *name )
    }
 
    // Initialise with safe parameters
-   InitCommon( cpucache_emumode, cart_type, region, horrible_hacks );
+   InitCommon( cpucache_emumode, cart_type, region, horrible_hacks, idleskip );
 
    MDFN_LoadGameCheats(NULL);
    MDFNMP_InstallReadPatches();
@@ -2041,6 +2351,7 @@ bool retro_load_game(const struct retro_game_info *info)
 #endif
 
    input_init();
+   SS_InvalidateStateSize();
 
    boot = false;
 
@@ -2085,6 +2396,8 @@ void retro_unload_game(void)
    }
 
    MDFNMP_Kill();
+   MDFN_StateEvilFlush();
+   SS_InvalidateStateSize();
 
    MDFNGameInfo = NULL;
 
@@ -2096,11 +2409,50 @@ void retro_unload_game(void)
 }
 
 static uint64_t video_frames, audio_frames;
-#define SOUND_CHANNELS 2
+
+static void RunFrame(EmulateSpecStruct* espec)
+{
+   if (MDFN_UNLIKELY(SS_ProfileActive))
+   {
+      const uint64 start_time = ProfileClockNS();
+
+      Emulate(espec);
+      SS_Profile.emulate_ns += ProfileClockNS() - start_time;
+   }
+   else
+      Emulate(espec);
+}
+
+/*
+ * Core-side run-ahead: the frame that counts has already been emulated, with rendering skipped.  Snapshot it, emulate
+ * setting_run_ahead more frames with the same input, rendering only the last one and discarding their audio, then go
+ * back to the snapshot.  The snapshot is a delta one(see mednafen/state_rewind.cpp), so it costs little more than the
+ * VDP2 render thread catching up; the skipped frames only update the renderer's line state.
+ */
+static bool RunAhead(EmulateSpecStruct* espec)
+{
+   if (!MDFN_RunAheadSave())
+   {
+      log_cb(RETRO_LOG_WARN, "[Mednafen]: Run-ahead snapshot failed; running without run-ahead until the option is changed.\n");
+      RunAheadFailed = true;
+      return false;
+   }
+
+   for (int i = 0; i < setting_run_ahead; i++)
+   {
+      espec->skip = (i + 1) < setting_run_ahead;
+      RunFrame(espec);
+   }
+
+   MDFN_RunAheadLoad();
+
+   return true;
+}
 
 void retro_run(void)
 {
    bool updated = false;
+   int av_enable = 0;
    bool hires_h_mode;
    unsigned overscan_mask;
    unsigned linevisfirst, linevislast;
@@ -2110,6 +2462,10 @@ void retro_run(void)
    if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE_UPDATE, &updated) && updated)
       check_variables(false);
 
+   /* Bit 0 clear: the frontend won't show this frame; bit 1 clear: it won't play its audio(e.g. its own run-ahead). */
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable))
+      av_enable = 3;
+
    linevisfirst   =  is_pal ? first_sl_pal : first_sl;
    linevislast    =  is_pal ? last_sl_pal : last_sl;
 
@@ -2122,18 +2478,22 @@ void retro_run(void)
 
    input_update(libretro_supports_bitmasks, input_state_cb );
 
+   if (MDFN_StateEvilIsRunning())
+      MDFN_StateEvil(input_state_cb(0, RETRO_DEVICE_JOYPAD, 0, setting_rewind_button) != 0);
+
    static int32 rects[MEDNAFEN_CORE_GEOMETRY_MAX_H];
    rects[0] = ~0;
 
    EmulateSpecStruct spec = {0};
    spec.surface = surf;
-   spec.SoundRate = 44100;
+   spec.SoundRate = setting_audio_rate;
    spec.LineWidths = rects;
    spec.SoundVolume = 1.0;
    spec.soundmultiplier = 1.0;
    spec.SoundBufSize = 0;
    spec.VideoFormatChanged = false;
    spec.SoundFormatChanged = false;
+   spec.skip = !(av_enable & 1) || (setting_run_ahead > 0 && !RunAheadFailed);
 
    EmulateSpecStruct *espec = (EmulateSpecStruct*)&spec;
 
@@ -2143,7 +2503,27 @@ void retro_run(void)
       last_sound_rate = spec.SoundRate;
    }
 
-   Emulate(espec);
+   RunFrame(espec);
+
+   video_frames++;
+   audio_frames += spec.SoundBufSize;
+
+   if (av_enable & 2)
+   {
+      int16_t *interbuf = (int16_t*)&IBuffer;
+
+      OutputAudio(interbuf, spec.SoundBufSize);
+   }
+
+   /* The frame was emulated with rendering skipped, so there's nothing to show for it if the snapshot fails. */
+   if ((av_enable & 1) && setting_run_ahead > 0 && !RunAheadFailed && !RunAhead(espec))
+      spec.skip = true;
+
+   if (spec.skip)
+   {
+      video_cb(NULL, game_width, game_height, FB_WIDTH * sizeof(uint32_t));
+      return;
+   }
 
 #ifdef NEED_DEINTERLACER
    if (spec.InterlaceOn)
@@ -2197,13 +2577,6 @@ void retro_run(void)
    fb = pix;
 
    video_cb(fb, game_width, game_height, pitch);
-
-   video_frames++;
-   audio_frames += spec.SoundBufSize;
-
-   int16_t *interbuf = (int16_t*)&IBuffer;
-
-   audio_batch_cb(interbuf, spec.SoundBufSize);
 }
 
 void retro_get_system_info(struct retro_system_info *info)
@@ -2222,7 +2595,7 @@ void retro_get_system_info(struct retro_system_info *info)
 void retro_get_system_av_info(struct retro_system_av_info *info)
 {
    memset(info, 0, sizeof(*info));
-   info->timing.sample_rate    = 44100;
+   info->timing.sample_rate    = setting_audio_rate;
    info->geometry.base_width   = MEDNAFEN_CORE_GEOMETRY_BASE_W;
    info->geometry.base_height  = MEDNAFEN_CORE_GEOMETRY_BASE_H;
    info->geometry.max_width    = MEDNAFEN_CORE_GEOMETRY_MAX_W;
@@ -2240,6 +2613,18 @@ void retro_deinit(void)
    delete surf;
    surf = NULL;
 
+   delete AudioResampler;
+   AudioResampler = NULL;
+
+   MDFN_StateEvilEnd();
+   setting_rewind_depth = 0;
+   setting_rewind_button = -1;
+   RewindDepth = 0;
+
+   MDFN_RunAheadEnd();
+   setting_run_ahead = 0;
+   RunAheadFailed = false;
+
    log_cb(RETRO_LOG_INFO, "[%s]: Samples / Frame: %.5f\n",
          MEDNAFEN_CORE_NAME, (double)audio_frames / video_frames);
    log_cb(RETRO_LOG_INFO, "[%s]: Estimated FPS: %.5f\n",
@@ -2270,6 +2655,17 @@ void retro_set_environment( retro_environment_t cb )
    libretro_set_core_options(environ_cb,
            &libretro_supports_option_categories);
 
+#ifndef HAVE_ZLIB_DEFLATE
+   {
+      /* The bundled zlib has no deflate; see MDFNSS_SaveSMCompressed(). */
+      struct retro_core_option_display option_display;
+
+      option_display.key     = "beetle_saturn_state_compression";
+      option_display.visible = false;
+      environ_cb(RETRO_ENVIRONMENT_SET_CORE_OPTIONS_DISPLAY, &option_display);
+   }
+#endif
+
    vfs_iface_info.required_interface_version = 1;
    vfs_iface_info.iface                      = NULL;
    if (environ_cb(RETRO_ENVIRONMENT_GET_VFS_INTERFACE, &vfs_iface_info))
@@ -2303,14 +2699,22 @@ void retro_set_video_refresh(retro_video_refresh_t cb)
    video_cb = cb;
 }
 
+/*
+ * Size of a state in the named layout, the larger of the two.  Measured by a sizing pass over the state tables, which
+ * copies nothing, and measured again after anything that can change the layout: loading or unloading a game, or
+ * connecting a different controller.
+ */
 static size_t serialize_size = 0;
 
+void SS_InvalidateStateSize(void)
+{
+   serialize_size = 0;
+}
+
 size_t retro_serialize_size(void)
 {
-   // Don't know yet?
-   if ( serialize_size == 0 )
+   if (serialize_size == 0 && MDFNGameInfo)
    {
-      // Do a fake save to see.
       StateMem st;
 
       st.data           = NULL;
@@ -2318,38 +2722,54 @@ size_t retro_serialize_size(void)
       st.len            = 0;
       st.malloced       = 0;
       st.initial_malloc = 0;
+      st.fixed          = false;
+      st.overflow       = false;
+      st.fast           = false;
+      st.delta          = false;
+      st.sizing         = true;
 
-      if ( MDFNSS_SaveSM( &st, MEDNAFEN_CORE_VERSION_NUMERIC, NULL, NULL, NULL ) )
-      {
-         // Cache and tidy up.
+      if (MDFNSS_SaveSM(&st, MEDNAFEN_CORE_VERSION_NUMERIC, NULL, NULL, NULL))
          serialize_size = st.len;
-         if (st.data)
-            free(st.data);
-      }
    }
 
-   // Return cached value.
    return serialize_size;
 }
 
+/* The frontend's run-ahead, rewind and netplay states never leave this session, so they use the fast layout. */
+static bool UseFastSavestates(void)
+{
+   int av_enable = 0;
+
+   return environ_cb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &av_enable) && (av_enable & 4);
+}
+
 bool retro_serialize(void *data, size_t size)
 {
-   /* it seems that mednafen can realloc pointers sent to it?
-      since we don't know the disposition of void* data (is it safe to realloc?) we have to manage a new buffer here */
+   /* Written straight into the frontend's buffer, which is never reallocated; a state that doesn't fit fails. */
    StateMem st;
    bool ret          = false;
-   uint8_t *_dat     = (uint8_t*)malloc(size);
 
-   st.data           = _dat;
+   st.data           = (uint8_t*)data;
    st.loc            = 0;
    st.len            = 0;
    st.malloced       = size;
    st.initial_malloc = 0;
+   st.fixed          = true;
+   st.overflow       = false;
+   st.fast           = UseFastSavestates();
+   st.delta          = false;
+   st.sizing         = false;
+
+   /* Only states in the named layout are stored; the fast ones are taken too often to be worth compressing. */
+   if (setting_state_compression && !st.fast)
+      ret            = MDFNSS_SaveSMCompressed(&st, MEDNAFEN_CORE_VERSION_NUMERIC);
+   else
+      ret            = MDFNSS_SaveSM(&st, MEDNAFEN_CORE_VERSION_NUMERIC, NULL, NULL, NULL);
 
-   ret               = MDFNSS_SaveSM(&st, MEDNAFEN_CORE_VERSION_NUMERIC, NULL, NULL, NULL);
+   /* Keep the unused tail deterministic, for frontends that compare states. */
+   if (ret && st.len < size)
+      memset(st.data + st.len, 0, size - st.len);
 
-   memcpy(data,st.data,size);
-   free(st.data);
    return ret;
 }
 
@@ -2362,6 +2782,14 @@ bool retro_unserialize(const void *data, size_t size)
    st.len            = size;
    st.malloced       = 0;
    st.initial_malloc = 0;
+   st.fixed          = false;
+   st.overflow       = false;
+   st.fast           = false;
+   st.delta          = false;
+   st.sizing         = false;
+
+   /* Whatever this overwrites, the rewind ring didn't see being written. */
+   MDFN_StateEvilFlush();
 
    return MDFNSS_LoadSM(&st, MEDNAFEN_CORE_VERSION_NUMERIC);
 }
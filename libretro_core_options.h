@@ -61,6 +61,11 @@ struct retro_core_option_v2_category option_cats_us[] = {
       "Cartridge / Memory Card",
       "This lets you modify settings related to the Saturn cartridge and the virtual Memory Card(s) used by the system."
    },
+   {
+      "audio",
+      "Audio",
+      "Configure audio output sample rate and buffering."
+   },
    {
       "hacks",
       "Emulation hacks",
@@ -365,6 +370,88 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "disabled"
    },
+   {
+      "beetle_saturn_vdp1_thread",
+      "VDP1 Draw Thread",
+      NULL,
+      "Draws VDP1 sprites, polygons and lines on a separate thread, in parallel with the rest of the emulation. Can help 3D-heavy games on hosts with a spare CPU core. Output is identical regardless of this setting.",
+      NULL,
+      "video",
+      {
+         { "disabled", NULL },
+         { "enabled", NULL },
+         { NULL, NULL },
+      },
+      "disabled"
+   },
+   {
+      "beetle_saturn_audio_rate",
+      "Audio Output Rate",
+      NULL,
+      "Sample rate of the audio sent to the frontend. The Saturn's sound chip runs at 44100 Hz; other rates are converted in the core with a high-quality resampler, which can save the frontend a resampling stage when it matches the audio device's rate.",
+      NULL,
+      "audio",
+      {
+         { "44100", "44100 Hz (Native)" },
+         { "48000", "48000 Hz" },
+         { "96000", "96000 Hz" },
+         { "32000", "32000 Hz" },
+         { "22050", "22050 Hz" },
+         { NULL, NULL },
+      },
+      "44100"
+   },
+   {
+      "beetle_saturn_audio_chunk",
+      "Audio Chunk Size",
+      NULL,
+      "Sends audio to the frontend in batches of exactly this many sample frames, carrying any remainder over to the next video frame, instead of one batch of varying size per video frame.",
+      NULL,
+      "audio",
+      {
+         { "0", "Disabled" },
+         { "128", NULL },
+         { "256", NULL },
+         { "512", NULL },
+         { "1024", NULL },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "beetle_saturn_vdp2_mix_threads",
+      "VDP2 Mixing Threads",
+      NULL,
+      "Number of extra threads used to mix the VDP2 background and sprite layers of each scanline together, in parallel with the VDP2 render thread drawing the next scanlines. Can help at high resolutions on hosts with many CPU cores. Output is identical regardless of this setting.",
+      NULL,
+      "video",
+      {
+         { "0", "Disabled" },
+         { "1", NULL },
+         { "2", NULL },
+         { "3", NULL },
+         { "4", NULL },
+         { "6", NULL },
+         { "8", NULL },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "beetle_saturn_vdp2_wait_mode",
+      "VDP2 Render Thread Waiting",
+      NULL,
+      "How the VDP2 render thread waits for scanlines to draw, and the emulation thread for the render thread at the end of each frame. 'Busy-Wait' spins a host CPU core for part of every frame for the lowest latency. 'Spin, Then Sleep' spins briefly before sleeping. 'Sleep' sleeps right away, using the least CPU time, which helps when running many instances on one host, at the cost of some latency.",
+      NULL,
+      "video",
+      {
+         { "busywait",   "Busy-Wait" },
+         { "spin_sleep", "Spin, Then Sleep" },
+         { "sleep",      "Sleep" },
+         { NULL, NULL },
+      },
+      "busywait"
+   },
    {
       "beetle_saturn_multitap_port1",
       "6Player Adaptor on Port 1",
@@ -626,6 +713,105 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "disabled"
    },
+   {
+      "beetle_saturn_chd_hunk_cache",
+      "CHD Hunk Cache (Restart)",
+      NULL,
+      "Number of decompressed hunks (about 8 sectors each) of a CHD image kept in memory, so that reads bouncing between nearby hunks don't decompress them again. Requires a restart in order for a change to take effect.",
+      NULL,
+      NULL,
+      {
+         { "1",  NULL },
+         { "4",  NULL },
+         { "8",  NULL },
+         { "16", NULL },
+         { "32", NULL },
+         { "64", NULL },
+         { NULL, NULL },
+      },
+      "16"
+   },
+   {
+      "beetle_saturn_chd_decode_threads",
+      "CHD Decompression Threads (Restart)",
+      NULL,
+      "Number of threads decompressing the hunks of a CHD image ahead of the one being read, two hunks per thread (but at most half the hunk cache). Can help FMV-heavy games streaming from CHD images on hosts with spare CPU cores. Requires a restart in order for a change to take effect.",
+      NULL,
+      NULL,
+      {
+         { "0", "Disabled" },
+         { "1", NULL },
+         { "2", NULL },
+         { "3", NULL },
+         { "4", NULL },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "beetle_saturn_rewind_depth",
+      "Rewind Depth",
+      NULL,
+      "Number of frames the core keeps snapshots of, to step back through by holding the Rewind Button on the first controller. Snapshots only store the memory pages that changed since the previous frame. Kept separately from, and not needed for, the frontend's own rewind.",
+      NULL,
+      NULL,
+      {
+         { "0", "Disabled" },
+         { "60", NULL },
+         { "300", NULL },
+         { "600", NULL },
+         { "1800", NULL },
+         { "3600", NULL },
+         { NULL, NULL },
+      },
+      "0"
+   },
+   {
+      "beetle_saturn_rewind_button",
+      "Rewind Button",
+      NULL,
+      "RetroPad button on the first controller that steps back through the Rewind Depth snapshots while held. No snapshots are taken while this is disabled. R3 is also the Mission Stick's throttle latch.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "l3", "L3" },
+         { "r3", "R3" },
+         { NULL, NULL },
+      },
+      "disabled"
+   },
+   {
+      "beetle_saturn_state_compression",
+      "Compress Save States",
+      NULL,
+      "Compresses save states with zlib, typically to a small fraction of their size, at the cost of a few milliseconds per save. Compressed states are recognized and loaded whether or not this is enabled. Doesn't apply to the frontend's run-ahead, rewind and netplay states. Only available in builds linked against a complete zlib.",
+      NULL,
+      NULL,
+      {
+         { "disabled", NULL },
+         { "enabled", NULL },
+         { NULL, NULL },
+      },
+      "disabled"
+   },
+   {
+      "beetle_saturn_run_ahead",
+      "Run-Ahead Frames",
+      NULL,
+      "Cuts input latency by this many frames: after each frame, the core emulates that many more frames ahead, shows the last one, and goes back. Only that last frame is rendered, and snapshots only store the memory pages that changed, so this is lighter than the frontend's run-ahead. Use one or the other, not both. Needs more CPU for every frame added.",
+      NULL,
+      NULL,
+      {
+         { "0", "Disabled" },
+         { "1", NULL },
+         { "2", NULL },
+         { "3", NULL },
+         { "4", NULL },
+         { NULL, NULL },
+      },
+      "0"
+   },
    
    
    {
@@ -642,6 +828,21 @@ struct retro_core_option_v2_definition option_defs_us[] = {
       },
       "disabled"
    },
+   {
+      "beetle_saturn_sh2_idleskip",
+      "SH-2 Idle Loop Skipping",
+      NULL,
+      "Detects short SH-2 polling loops (e.g. waiting for VBlank) and skips ahead to the next emulated event instead of running them instruction by instruction. 'Allowlisted' only enables it for games known to work with it; 'Enabled' enables it for all games not known to break with it. Has no effect on games that need instruction cache emulation.",
+      NULL,
+      "hacks",
+      {
+         { "disabled",    NULL },
+         { "allowlisted", "Allowlisted" },
+         { "enabled",     NULL },
+         { NULL, NULL },
+      },
+      "disabled"
+   },
    {
       "beetle_saturn_autortc",
       "Automatically set RTC on game load",
@@ -15,3 +15,15 @@ bool setting_multitap_port1;
 bool setting_multitap_port2;
 bool opposite_directions;
 bool setting_midsync;
+int setting_sh2_idleskip = SETTING_SH2_IDLESKIP_DISABLED;
+int setting_vdp2_mix_threads = 0;
+int setting_vdp2_wait_mode = SETTING_VDP2_WAIT_BUSY;
+bool setting_vdp1_thread = false;
+int setting_audio_rate = 44100;
+int setting_audio_chunk = 0;
+int setting_chd_hunk_cache = 16;
+int setting_chd_decode_threads = 0;
+int setting_rewind_depth = 0;
+int setting_rewind_button = -1;
+int setting_run_ahead = 0;
+bool setting_state_compression = false;
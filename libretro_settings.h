@@ -16,6 +16,20 @@ enum
 	SETTING_GUN_INPUT_POINTER,
 };
 
+enum
+{
+	SETTING_SH2_IDLESKIP_DISABLED,
+	SETTING_SH2_IDLESKIP_ALLOWLISTED,
+	SETTING_SH2_IDLESKIP_ENABLED,
+};
+
+enum
+{
+	SETTING_VDP2_WAIT_BUSY,
+	SETTING_VDP2_WAIT_SPIN_SLEEP,
+	SETTING_VDP2_WAIT_SLEEP,
+};
+
 extern int setting_region;
 extern int setting_cart;
 extern bool setting_smpc_autortc;
@@ -31,5 +45,17 @@ extern bool setting_multitap_port1;
 extern bool setting_multitap_port2;
 extern bool opposite_directions;
 extern bool setting_midsync;
+extern int setting_sh2_idleskip;
+extern int setting_vdp2_mix_threads;
+extern int setting_vdp2_wait_mode;
+extern bool setting_vdp1_thread;
+extern int setting_audio_rate;
+extern int setting_audio_chunk;
+extern int setting_chd_hunk_cache;
+extern int setting_chd_decode_threads;
+extern int setting_rewind_depth;
+extern int setting_rewind_button;
+extern int setting_run_ahead;
+extern bool setting_state_compression;
 
 #endif
@@ -22,9 +22,12 @@
 #include "../git.h"
 #include "../general.h"
 #include "../mednafen-endian.h"
+#include "../settings.h"
 
 #include "CDAccess_CHD.h"
 
+#include <algorithm>
+
 // Disk-image(rip) track/sector formats
 enum
 {
@@ -51,7 +54,18 @@ static const int32_t DI_Size_Table[8] =
         2352  // CD-I RAW
 };
 
-CDAccess_CHD::CDAccess_CHD(const std::string &path, bool image_memcache) : NumTracks(0), total_sectors(0)
+// CHD_HUNK_CACHE_ENTRY states
+enum
+{
+  HUNK_EMPTY = 0,
+  HUNK_QUEUED,   // Waiting for a decompression thread.
+  HUNK_DECODING, // Being decompressed, by the reading thread or a decompression thread.
+  HUNK_READY
+};
+
+CDAccess_CHD::CDAccess_CHD(const std::string &path, bool image_memcache) : NumTracks(0), total_sectors(0), chd(NULL), hunkcount(0),
+    HunkMem(NULL), HunkUseCounter(0), HunkQueueSeq(0), ReadAheadHunks(0), HunkLock(NULL), HunkQueuedCond(NULL), HunkDoneCond(NULL),
+    DecodeThreadsExit(false), Stats_Hits(0), Stats_Misses(0), Stats_Waits(0)
 {
   Load(path, image_memcache);
 }
@@ -78,10 +92,28 @@ bool CDAccess_CHD::Load(const std::string &path, bool image_memcache)
 
   /* allocate storage for sector reads */
   const chd_header *head = chd_get_header(chd);
-  hunkmem = (uint8_t *)malloc(head->hunkbytes);
-  oldhunk = -1;
+  const unsigned cache_size = std::max<uint64>(1, MDFN_GetSettingUI("cdrom.chd.hunk_cache"));
+
+  hunkcount = head->hunkcount;
+  HunkMem = (uint8_t *)malloc((size_t)head->hunkbytes * cache_size);
+  HunkCache.resize(cache_size);
+
+  for (unsigned i = 0; i < cache_size; i++)
+  {
+    HunkCache[i].hunknum = -1;
+    HunkCache[i].state = HUNK_EMPTY;
+    HunkCache[i].last_use = 0;
+    HunkCache[i].queue_seq = 0;
+    HunkCache[i].data = HunkMem + (size_t)head->hunkbytes * i;
+  }
+
+  HunkLock = slock_new();
+  HunkQueuedCond = scond_new();
+  HunkDoneCond = scond_new();
 
-  log_cb(RETRO_LOG_INFO, "chd_load '%s' hunkbytes=%d\n", path.c_str(), head->hunkbytes);
+  StartDecodeThreads(path, MDFN_GetSettingUI("cdrom.chd.decode_threads"));
+
+  log_cb(RETRO_LOG_INFO, "chd_load '%s' hunkbytes=%d cache=%u threads=%u\n", path.c_str(), head->hunkbytes, cache_size, (unsigned)DecodeThreads.size());
 
   int plba = -150;
   int numsectors = 0;
@@ -204,11 +236,266 @@ bool CDAccess_CHD::Load(const std::string &path, bool image_memcache)
 
 CDAccess_CHD::~CDAccess_CHD()
 {
+  StopDecodeThreads();
+
+  if (Stats_Hits || Stats_Misses)
+    log_cb(RETRO_LOG_INFO, "CHD hunk cache: %llu hits, %llu misses; waited for decompression threads %llu times.\n",
+           (unsigned long long)Stats_Hits, (unsigned long long)Stats_Misses, (unsigned long long)Stats_Waits);
+
   if (chd != NULL)
     chd_close(chd);
 
-  if (hunkmem)
-    free(hunkmem);
+  if (HunkMem)
+    free(HunkMem);
+
+  if (HunkDoneCond)
+    scond_free(HunkDoneCond);
+
+  if (HunkQueuedCond)
+    scond_free(HunkQueuedCond);
+
+  if (HunkLock)
+    slock_free(HunkLock);
+}
+
+//
+// Decompression threads.
+//
+// GetHunk() queues the ReadAheadHunks hunks after the one being read for decompression into otherwise unused(least
+// recently used) cache entries, and the decompression threads pick them up in the order they were queued.  Only the
+// reading thread(the CD read thread, or the emulation thread with the image cached in memory) assigns cache entries,
+// so the data of an entry GetHunk() returns stays put until the next call.
+//
+void CDAccess_CHD::StartDecodeThreads(const std::string &path, unsigned count)
+{
+  DecodeThreads.reserve(count);
+
+  for (unsigned i = 0; i < count; i++)
+  {
+    CHD_DECODE_THREAD dt;
+
+    dt.owner = this;
+    dt.thread = NULL;
+
+    if (chd_open(path.c_str(), CHD_OPEN_READ, NULL, &dt.chd) != CHDERR_NONE)
+    {
+      log_cb(RETRO_LOG_WARN, "Failed to open CHD image for decompression thread: %s\n", path.c_str());
+      break;
+    }
+
+    DecodeThreads.push_back(dt);
+
+    if (!(DecodeThreads.back().thread = sthread_create(DecodeThreadEntry, &DecodeThreads.back())))
+    {
+      chd_close(dt.chd);
+      DecodeThreads.pop_back();
+      break;
+    }
+  }
+
+  ReadAheadHunks = std::min<int32_t>(2 * DecodeThreads.size(), HunkCache.size() / 2);
+}
+
+void CDAccess_CHD::StopDecodeThreads(void)
+{
+  if (DecodeThreads.empty())
+    return;
+
+  slock_lock(HunkLock);
+  DecodeThreadsExit = true;
+  scond_broadcast(HunkQueuedCond);
+  slock_unlock(HunkLock);
+
+  for (size_t i = 0; i < DecodeThreads.size(); i++)
+  {
+    sthread_join(DecodeThreads[i].thread);
+    chd_close(DecodeThreads[i].chd);
+  }
+
+  DecodeThreads.clear();
+  ReadAheadHunks = 0;
+}
+
+void CDAccess_CHD::DecodeThreadEntry(void *data)
+{
+  CHD_DECODE_THREAD *dt = (CHD_DECODE_THREAD *)data;
+
+  dt->owner->DecodeThreadMain(dt->chd);
+}
+
+void CDAccess_CHD::DecodeThreadMain(chd_file *tchd)
+{
+  slock_lock(HunkLock);
+
+  while (!DecodeThreadsExit)
+  {
+    CHD_HUNK_CACHE_ENTRY *job = NULL;
+
+    for (size_t i = 0; i < HunkCache.size(); i++)
+    {
+      CHD_HUNK_CACHE_ENTRY *e = &HunkCache[i];
+
+      if (e->state == HUNK_QUEUED && (!job || (int32_t)(e->queue_seq - job->queue_seq) < 0))
+        job = e;
+    }
+
+    if (!job)
+    {
+      scond_wait(HunkQueuedCond, HunkLock);
+      continue;
+    }
+
+    job->state = HUNK_DECODING;
+    slock_unlock(HunkLock);
+
+    const chd_error err = chd_read(tchd, job->hunknum, job->data);
+
+    slock_lock(HunkLock);
+
+    if (err != CHDERR_NONE)
+    {
+      // Left for GetHunk() to retry and report.
+      job->hunknum = -1;
+      job->state = HUNK_EMPTY;
+    }
+    else
+      job->state = HUNK_READY;
+
+    scond_signal(HunkDoneCond);
+  }
+
+  slock_unlock(HunkLock);
+}
+
+// Returns the least recently used entry not being decompressed and not used during the current GetHunk() call, or
+// NULL if there is none.  HunkLock must be held.
+CHD_HUNK_CACHE_ENTRY *CDAccess_CHD::FindVictim(void)
+{
+  CHD_HUNK_CACHE_ENTRY *ret = NULL;
+
+  for (size_t i = 0; i < HunkCache.size(); i++)
+  {
+    CHD_HUNK_CACHE_ENTRY *e = &HunkCache[i];
+
+    if (e->state == HUNK_DECODING || (e->hunknum >= 0 && e->last_use == HunkUseCounter))
+      continue;
+
+    if (e->hunknum < 0)
+      return e;
+
+    if (!ret || (HunkUseCounter - e->last_use) > (HunkUseCounter - ret->last_use))
+      ret = e;
+  }
+
+  return ret;
+}
+
+// Returns NULL if the hunk couldn't be read.
+const uint8_t *CDAccess_CHD::GetHunk(int32_t hunknum)
+{
+  CHD_HUNK_CACHE_ENTRY *e;
+  bool waited = false;
+  bool queued = false;
+
+  slock_lock(HunkLock);
+  HunkUseCounter++;
+
+  for (;;)
+  {
+    e = NULL;
+
+    for (size_t i = 0; i < HunkCache.size(); i++)
+    {
+      if (HunkCache[i].hunknum == hunknum)
+      {
+        e = &HunkCache[i];
+        break;
+      }
+    }
+
+    if (e && e->state == HUNK_DECODING)
+    {
+      // A decompression thread has already started on it.
+      waited = true;
+      scond_wait(HunkDoneCond, HunkLock);
+      continue;
+    }
+
+    if (!e && !(e = FindVictim()))
+    {
+      // Every other entry is being decompressed.
+      scond_wait(HunkDoneCond, HunkLock);
+      continue;
+    }
+
+    break;
+  }
+
+  Stats_Waits += waited;
+
+  if (e->hunknum == hunknum && e->state == HUNK_READY)
+    Stats_Hits++;
+  else
+  {
+    // Not cached, or still waiting in the queue; decompress it here.
+    Stats_Misses++;
+    e->hunknum = hunknum;
+    e->state = HUNK_DECODING;
+    slock_unlock(HunkLock);
+
+    const chd_error err = chd_read(chd, hunknum, e->data);
+
+    slock_lock(HunkLock);
+
+    if (err != CHDERR_NONE)
+    {
+      log_cb(RETRO_LOG_ERROR, "chd_read_sector failed hunk=%d error=%d\n", hunknum, err);
+      e->hunknum = -1;
+      e->state = HUNK_EMPTY;
+      slock_unlock(HunkLock);
+      return NULL;
+    }
+
+    e->state = HUNK_READY;
+  }
+
+  e->last_use = HunkUseCounter;
+
+  for (int32_t h = hunknum + 1; h <= hunknum + ReadAheadHunks && (uint32_t)h < hunkcount; h++)
+  {
+    CHD_HUNK_CACHE_ENTRY *v = NULL;
+
+    for (size_t i = 0; i < HunkCache.size(); i++)
+    {
+      if (HunkCache[i].hunknum == h)
+      {
+        v = &HunkCache[i];
+        break;
+      }
+    }
+
+    if (v)
+    {
+      v->last_use = HunkUseCounter;
+      continue;
+    }
+
+    if (!(v = FindVictim()))
+      break;
+
+    v->hunknum = h;
+    v->state = HUNK_QUEUED;
+    v->last_use = HunkUseCounter;
+    v->queue_seq = HunkQueueSeq++;
+    queued = true;
+  }
+
+  if (queued)
+    scond_broadcast(HunkQueuedCond);
+
+  slock_unlock(HunkLock);
+
+  return e->data;
 }
 
 bool CDAccess_CHD::Read_CHD_Hunk_RAW(uint8_t *buf, int32_t lba)
@@ -218,21 +505,19 @@ bool CDAccess_CHD::Read_CHD_Hunk_RAW(uint8_t *buf, int32_t lba)
   int sph = head->hunkbytes / (2352 + 96);
   int hunknum = cad / sph; //(cad * head->unitbytes) / head->hunkbytes;
   int hunkofs = cad % sph; //(cad * head->unitbytes) % head->hunkbytes;
-  int err = CHDERR_NONE;
 
-  /* each hunk holds ~8 sectors, optimize when reading contiguous sectors */
-  if (hunknum != oldhunk)
+  /* each hunk holds ~8 sectors, and recently used ones stay decompressed */
+  const uint8_t *hunk = GetHunk(hunknum);
+
+  if (!hunk)
   {
-    err = chd_read(chd, hunknum, hunkmem);
-    if (err != CHDERR_NONE)
-      log_cb(RETRO_LOG_ERROR, "chd_read_sector failed lba=%d error=%d\n", lba, err);
-    else
-      oldhunk = hunknum;
+    memset(buf, 0, 2352);
+    return false;
   }
 
-  memcpy(buf, hunkmem + hunkofs * (2352 + 96), 2352);
+  memcpy(buf, hunk + hunkofs * (2352 + 96), 2352);
 
-  return err;
+  return true;
 }
 
 bool CDAccess_CHD::Read_CHD_Hunk_M1(uint8_t *buf, int32_t lba)
@@ -242,21 +527,19 @@ bool CDAccess_CHD::Read_CHD_Hunk_M1(uint8_t *buf, int32_t lba)
   int sph = head->hunkbytes / (2352 + 96);
   int hunknum = cad / sph; //(cad * head->unitbytes) / head->hunkbytes;
   int hunkofs = cad % sph; //(cad * head->unitbytes) % head->hunkbytes;
-  int err = CHDERR_NONE;
 
-  /* each hunk holds ~8 sectors, optimize when reading contiguous sectors */
-  if (hunknum != oldhunk)
+  /* each hunk holds ~8 sectors, and recently used ones stay decompressed */
+  const uint8_t *hunk = GetHunk(hunknum);
+
+  if (!hunk)
   {
-    err = chd_read(chd, hunknum, hunkmem);
-    if (err != CHDERR_NONE)
-      log_cb(RETRO_LOG_ERROR, "chd_read_sector failed lba=%d error=%d\n", lba, err);
-    else
-      oldhunk = hunknum;
+    memset(buf + 16, 0, 2048);
+    return false;
   }
 
-  memcpy(buf + 16, hunkmem + hunkofs * (2352 + 96), 2048);
+  memcpy(buf + 16, hunk + hunkofs * (2352 + 96), 2048);
 
-  return err;
+  return true;
 }
 
 bool CDAccess_CHD::Read_CHD_Hunk_M2(uint8_t *buf, int32_t lba)
@@ -266,21 +549,19 @@ bool CDAccess_CHD::Read_CHD_Hunk_M2(uint8_t *buf, int32_t lba)
   int sph = head->hunkbytes / (2352 + 96);
   int hunknum = cad / sph; //(cad * head->unitbytes) / head->hunkbytes;
   int hunkofs = cad % sph; //(cad * head->unitbytes) % head->hunkbytes;
-  int err = CHDERR_NONE;
 
-  /* each hunk holds ~8 sectors, optimize when reading contiguous sectors */
-  if (hunknum != oldhunk)
+  /* each hunk holds ~8 sectors, and recently used ones stay decompressed */
+  const uint8_t *hunk = GetHunk(hunknum);
+
+  if (!hunk)
   {
-    err = chd_read(chd, hunknum, hunkmem);
-    if (err != CHDERR_NONE)
-      log_cb(RETRO_LOG_ERROR, "chd_read_sector failed lba=%d error=%d\n", lba, err);
-    else
-      oldhunk = hunknum;
+    memset(buf + 16, 0, 2336);
+    return false;
   }
 
-  memcpy(buf + 16, hunkmem + hunkofs * (2352 + 96), 2336);
+  memcpy(buf + 16, hunk + hunkofs * (2352 + 96), 2336);
 
-  return err;
+  return true;
 }
 
 bool CDAccess_CHD::Read_Raw_Sector(uint8_t *buf, int32_t lba)
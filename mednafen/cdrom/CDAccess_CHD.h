@@ -24,6 +24,9 @@
 
 #include "CDAccess.h"
 #include <libchdr/chd.h>
+#include <rthreads/rthreads.h>
+
+#include <vector>
 
 struct CHDFILE_TRACK_INFO
 {
@@ -49,6 +52,25 @@ struct CHDFILE_TRACK_INFO
 
 };
 
+// A decompressed hunk, or a slot for one.
+struct CHD_HUNK_CACHE_ENTRY
+{
+   int32_t hunknum; // -1 if empty.
+   uint8_t state;
+   uint32_t last_use;
+   uint32_t queue_seq;
+   uint8_t *data;
+};
+
+class CDAccess_CHD;
+
+struct CHD_DECODE_THREAD
+{
+   CDAccess_CHD *owner;
+   chd_file *chd; // Own handle, as a chd_file can only decompress one hunk at a time.
+   sthread_t *thread;
+};
+
 class CDAccess_CHD : public CDAccess
 {
  public:
@@ -70,6 +92,14 @@ class CDAccess_CHD : public CDAccess
   // MakeSubPQ will OR the simulated P and Q subchannel data into SubPWBuf.
   int32_t MakeSubPQ(int32_t lba, uint8_t *SubPWBuf) const;
 
+  void StartDecodeThreads(const std::string& path, unsigned count);
+  void StopDecodeThreads(void);
+  void DecodeThreadMain(chd_file *tchd);
+  static void DecodeThreadEntry(void *data);
+
+  CHD_HUNK_CACHE_ENTRY *FindVictim(void);
+  const uint8_t *GetHunk(int32_t hunknum);
+
   bool Read_CHD_Hunk_RAW(uint8_t *buf, int32_t lba);
   bool Read_CHD_Hunk_M1(uint8_t *buf, int32_t lba);
   bool Read_CHD_Hunk_M2(uint8_t *buf, int32_t lba);
@@ -89,8 +119,23 @@ class CDAccess_CHD : public CDAccess
   int num_tracks;
 
   chd_file *chd;
-  /* hunk data cache */
-  uint8_t *hunkmem;
-  /* last hunknum read */
-  int oldhunk;
+  uint32_t hunkcount;
+
+  /* LRU cache of decompressed hunks, protected by HunkLock */
+  std::vector<CHD_HUNK_CACHE_ENTRY> HunkCache;
+  uint8_t *HunkMem;
+  uint32_t HunkUseCounter;
+  uint32_t HunkQueueSeq;
+  int32_t ReadAheadHunks;
+
+  /* decompression threads, each with its own handle to the image */
+  std::vector<CHD_DECODE_THREAD> DecodeThreads;
+  slock_t *HunkLock;
+  scond_t *HunkQueuedCond;
+  scond_t *HunkDoneCond;
+  bool DecodeThreadsExit;
+
+  uint64_t Stats_Hits;
+  uint64_t Stats_Misses;
+  uint64_t Stats_Waits;
 };
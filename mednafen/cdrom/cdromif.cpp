@@ -20,71 +20,43 @@
 
 #include <boolean.h>
 #include <rthreads/rthreads.h>
+#include <rthreads/rsemaphore.h>
 #include <retro_miscellaneous.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 
 #include "cdromif.h"
 #include "CDAccess.h"
 #include "../git.h"
 #include "../general.h"
 
-enum
-{
-   /* Status/Error messages */
-   CDIF_MSG_DONE = 0,		   /* Read -> emu. args: No args. */
-   CDIF_MSG_INFO,			      /* Read -> emu. args: str_message */
-   CDIF_MSG_FATAL_ERROR,		/* Read -> emu. args: *TODO ARGS* */
-
-   /* Command messages. */
-   CDIF_MSG_DIEDIEDIE,		   /* Emu -> read */
-
-   CDIF_MSG_READ_SECTOR		   /* Emu -> read
-                              args[0] = lba
-                              */
-};
-
-class CDIF_Message
-{
-   public:
-
-      CDIF_Message();
-      CDIF_Message(unsigned int message_, uint32_t arg0 = 0, uint32_t arg1 = 0, uint32_t arg2 = 0, uint32_t arg3 = 0);
-      CDIF_Message(unsigned int message_, const std::string &str);
-      ~CDIF_Message();
-
-      unsigned int message;
-      uint32_t args[4];
-      void *parg;
-      std::string str_message;
-};
-
-class CDIF_Queue
-{
-   public:
-
-      CDIF_Queue();
-      ~CDIF_Queue();
-
-      bool Read(CDIF_Message *message, bool blocking = true);
-
-      void Write(const CDIF_Message &message);
-
-   private:
-      std::queue<CDIF_Message> ze_queue;
-      slock_t *ze_mutex;
-      scond_t *ze_cond;
-};
-
-
 typedef struct
 {
-   bool valid;
    bool error;
    int32_t lba;
    uint8_t data[2352 + 96];
 } CDIF_Sector_Buffer;
 
+/*
+ * The read thread fills SectorBuffers[] as a single-producer single-consumer ring: slots
+ * [SBRead, SBWritten) hold sectors the emulation thread may still ask for, in the order they
+ * were read, and only the read thread writes the slot at SBWritten, and only while the ring
+ * isn't full.  The emulation thread looks sectors up between the two positions, and retires
+ * everything before a sector it finds(or, when it doesn't find one, everything) by moving
+ * SBRead forward.
+ *
+ * Requests(the LBA the emulation thread last read or hinted at) go the other way through
+ * ReqLBA and ReqSerial; the read thread only cares about the latest one.  How far the read
+ * thread reads ahead of it starts small after a seek and grows while the requests keep
+ * following the sectors it's reading, so FMV and audio streaming build up a deep buffer while
+ * random seeks don't waste time reading sectors that won't be used.
+ *
+ * Either thread spins briefly and then parks on a semaphore when it has nothing to do, in the
+ * same way as the VDP1 draw thread.
+ */
+
 // TODO: prohibit copy constructor
 class CDIF_MT : public CDIF
 {
@@ -102,30 +74,46 @@ class CDIF_MT : public CDIF
 
    private:
 
+      void Request(int32_t lba);
+      void WaitSector(uint32_t written);
+
       CDAccess *disc_cdaccess;
 
       sthread_t *CDReadThread;
 
-      // Queue for messages to the read thread.
-      CDIF_Queue ReadThreadQueue;
-
-      // Queue for messages to the emu thread.
-      CDIF_Queue EmuThreadQueue;
+      ssem_t *ReadWakeupSem;
+      ssem_t *SectorSem;
 
+      enum : uint32_t { SBSize = 256 };	// Power of 2
+      enum : int32_t { RA_Initial = 2 };
+      enum : int32_t { RA_Max = 192 };
+      enum : unsigned { SpinCount = 0x400 };
 
-      enum { SBSize = 256 };
       CDIF_Sector_Buffer SectorBuffers[SBSize];
 
-      uint32_t SBWritePos;
+      std::atomic_uint_least32_t SBWritten;	// Free-running count of sectors read into the ring.
+      std::atomic_uint_least32_t SBRead;	// Free-running count of sectors retired from the ring.
 
-      slock_t *SBMutex;
-      scond_t *SBCond;
+      std::atomic_int_least32_t ReqLBA;
+      std::atomic_uint_least32_t ReqSerial;
+      std::atomic_bool ExitRequested;
 
+      std::atomic_bool ReadParked;
+      std::atomic_bool SectorWaiting;
+
+      /* Emulation-thread-only: */
+      uint32_t ReqSerialPos;
+      uint64_t Stats_Hits;
+      uint64_t Stats_Misses;
+      uint64_t Stats_StallNS;
 
       /* Read-thread-only: */
       int32_t ra_lba;
-      int32_t ra_count;
-      int32_t last_read_lba;
+      int32_t ra_depth;
+      int32_t last_req_lba;
+      uint64_t Stats_Seeks;
+      uint64_t Stats_SectorsRead;
+      int32_t Stats_MaxDepth;
 };
 
 
@@ -155,89 +143,17 @@ CDIF::~CDIF()
 
 }
 
-
-CDIF_Message::CDIF_Message()
-{
-   message = 0;
-
-   memset(args, 0, sizeof(args));
-}
-
-CDIF_Message::CDIF_Message(unsigned int message_, uint32_t arg0, uint32_t arg1, uint32_t arg2, uint32_t arg3)
-{
-   message = message_;
-   args[0] = arg0;
-   args[1] = arg1;
-   args[2] = arg2;
-   args[3] = arg3;
-}
-
-CDIF_Message::CDIF_Message(unsigned int message_, const std::string &str)
-{
-   message = message_;
-   str_message = str;
-}
-
-CDIF_Message::~CDIF_Message()
-{
-
-}
-
-CDIF_Queue::CDIF_Queue()
-{
-   ze_mutex = slock_new();
-   ze_cond  = scond_new();
-}
-
-CDIF_Queue::~CDIF_Queue()
-{
-   slock_free(ze_mutex);
-   scond_free(ze_cond);
-}
-
-/* Returns false if message not read, true if it was read.  Will always return true if "blocking" is set.
- * Will throw MDFN_Error if the read message code is CDIF_MSG_FATAL_ERROR */
-bool CDIF_Queue::Read(CDIF_Message *message, bool blocking)
-{
-   bool ret = false;
-
-   slock_lock(ze_mutex);
-
-   if(blocking)
-   {
-      while(ze_queue.size() == 0)
-         scond_wait(ze_cond, ze_mutex);
-   }
-
-   if(ze_queue.size() != 0)
-   {
-      ret = true;
-      *message = ze_queue.front();
-      ze_queue.pop();
-   }  
-
-   slock_unlock(ze_mutex);
-
-   if(ret)
-   {
-      if (message->message != CDIF_MSG_FATAL_ERROR)
-         return true;
-
-      log_cb(RETRO_LOG_ERROR, "%s", message->str_message.c_str());
-   }
-
-   return false;
-}
-
-void CDIF_Queue::Write(const CDIF_Message &message)
-{
-   slock_lock(ze_mutex);
-
-   ze_queue.push(message);
-
-   scond_signal(ze_cond); /* Signal while the mutex is held to prevent icky race conditions */
-
-   slock_unlock(ze_mutex);
+static INLINE void CDIF_CPURelax(void)
+{
+#if defined(_MSC_VER)
+   __nop();
+#elif defined(__i386__) || defined(__x86_64__)
+   asm volatile("pause");
+#elif defined(__aarch64__)
+   asm volatile("yield");
+#else
+   std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
 }
 
 struct RTS_Args
@@ -254,12 +170,12 @@ static int ReadThreadStart_C(void *v_arg)
 
 int CDIF_MT::ReadThreadStart()
 {
-   bool Running = true;
+   uint32_t write_pos = 0;
+   uint32_t serial = 0;
 
-   SBWritePos = 0;
    ra_lba = 0;
-   ra_count = 0;
-   last_read_lba = LBA_Read_Maximum + 1;
+   ra_depth = 0;
+   last_req_lba = LBA_Read_Maximum + 1;
 
    disc_cdaccess->Read_TOC(&disc_toc);
 
@@ -268,124 +184,132 @@ int CDIF_MT::ReadThreadStart()
       log_cb(RETRO_LOG_ERROR, "TOC first(%d)/last(%d) track numbers bad.\n", disc_toc.first_track, disc_toc.last_track);
    }
 
-   SBWritePos = 0;
-   ra_lba = 0;
-   ra_count = 0;
-   last_read_lba = LBA_Read_Maximum + 1;
-   memset(SectorBuffers, 0, SBSize * sizeof(CDIF_Sector_Buffer));
-
-   EmuThreadQueue.Write(CDIF_Message(CDIF_MSG_DONE));
+   /* The constructor waits for the TOC. */
+   ssem_signal(SectorSem);
 
-   while(Running)
+   for(;;)
    {
-      CDIF_Message msg;
+      const uint32_t new_serial = ReqSerial.load(std::memory_order_acquire);
 
-      // Only do a blocking-wait for a message if we don't have any sectors to read-ahead.
-      // MDFN_DispMessage("%d %d %d\n", last_read_lba, ra_lba, ra_count);
-      if(ReadThreadQueue.Read(&msg, ra_count ? false : true))
+      if(new_serial != serial)
       {
-         switch(msg.message)
+         const int32_t new_lba = ReqLBA.load(std::memory_order_relaxed);
+
+         serial = new_serial;
+
+         if(ExitRequested.load(std::memory_order_relaxed))
+            break;
+
+         if(new_lba > last_req_lba && new_lba <= ra_lba)
+         {
+            /* Still following the sectors being read ahead; read further ahead. */
+            ra_depth = std::min<int32_t>(RA_Max, ra_depth + (new_lba - last_req_lba));
+            Stats_MaxDepth = std::max<int32_t>(Stats_MaxDepth, ra_depth);
+         }
+         else if(new_lba != last_req_lba)
          {
-            case CDIF_MSG_DIEDIEDIE:
-               Running = false;
-               break;
-
-            case CDIF_MSG_READ_SECTOR:
-               {
-                  static const int max_ra = 16;
-                  static const int initial_ra = 1;
-                  static const int speedmult_ra = 2;
-                  int32_t new_lba = msg.args[0];
-
-                  assert((unsigned int)max_ra < (SBSize / 4));
-
-                  if(new_lba == (last_read_lba + 1))
-                  {
-                     int how_far_ahead = ra_lba - new_lba;
-
-                     if(how_far_ahead <= max_ra)
-                        ra_count = std::min(speedmult_ra, 1 + max_ra - how_far_ahead);
-                     else
-                        ra_count++;
-                  }
-                  else if(new_lba != last_read_lba)
-                  {
-                     ra_lba = new_lba;
-                     ra_count = initial_ra;
-                  }
-
-                  last_read_lba = new_lba;
-               }
-               break;
+            ra_lba = new_lba;
+            ra_depth = RA_Initial;
+            Stats_Seeks++;
          }
+
+         last_req_lba = new_lba;
       }
 
       /* Don't read beyond what the disc (image) readers can handle sanely. */
-      if(ra_count && ra_lba == LBA_Read_Maximum)
-         ra_count = 0;
-
-      if(ra_count)
+      if(ra_lba <= LBA_Read_Maximum && (ra_lba - last_req_lba) < ra_depth && (write_pos - SBRead.load(std::memory_order_acquire)) < SBSize)
       {
-         uint8_t tmpbuf[2352 + 96];
-         bool error_condition = false;
-
-         disc_cdaccess->Read_Raw_Sector(tmpbuf, ra_lba);
+         CDIF_Sector_Buffer *sb = &SectorBuffers[write_pos & (SBSize - 1)];
 
-         slock_lock(SBMutex);
+         disc_cdaccess->Read_Raw_Sector(sb->data, ra_lba);
+         sb->lba = ra_lba;
+         sb->error = false;
 
-         SectorBuffers[SBWritePos].lba = ra_lba;
-         memcpy(SectorBuffers[SBWritePos].data, tmpbuf, 2352 + 96);
-         SectorBuffers[SBWritePos].valid = true;
-         SectorBuffers[SBWritePos].error = error_condition;
-         SBWritePos = (SBWritePos + 1) % SBSize;
+         write_pos++;
+         SBWritten.store(write_pos, std::memory_order_seq_cst);
 
-         scond_signal(SBCond);
-         slock_unlock(SBMutex);
+         if(SectorWaiting.load(std::memory_order_seq_cst) && SectorWaiting.exchange(false, std::memory_order_seq_cst))
+            ssem_signal(SectorSem);
 
          ra_lba++;
-         ra_count--;
+         Stats_SectorsRead++;
+         continue;
+      }
+
+      for(unsigned i = 0; i < SpinCount && serial == ReqSerial.load(std::memory_order_acquire); i++)
+         CDIF_CPURelax();
+
+      if(serial == ReqSerial.load(std::memory_order_acquire))
+      {
+         ReadParked.store(true, std::memory_order_seq_cst);
+
+         if(serial == ReqSerial.load(std::memory_order_seq_cst) || !ReadParked.exchange(false, std::memory_order_seq_cst))
+            ssem_wait(ReadWakeupSem);
+
+         ReadParked.store(false, std::memory_order_relaxed);
       }
    }
 
    return(1);
 }
 
-CDIF_MT::CDIF_MT(CDAccess *cda) : disc_cdaccess(cda), CDReadThread(NULL), SBMutex(NULL), SBCond(NULL)
+CDIF_MT::CDIF_MT(CDAccess *cda) : disc_cdaccess(cda), CDReadThread(NULL), ReadWakeupSem(NULL), SectorSem(NULL)
 {
-   CDIF_Message msg;
    RTS_Args s;
 
-   SBMutex            = slock_new();
-   SBCond             = scond_new();
+   ReadWakeupSem      = ssem_new(0);
+   SectorSem          = ssem_new(0);
+
+   SBWritten.store(0, std::memory_order_relaxed);
+   SBRead.store(0, std::memory_order_relaxed);
+   ReqLBA.store(LBA_Read_Maximum + 1, std::memory_order_relaxed);
+   ReqSerial.store(0, std::memory_order_relaxed);
+   ExitRequested.store(false, std::memory_order_relaxed);
+   ReadParked.store(false, std::memory_order_relaxed);
+   SectorWaiting.store(false, std::memory_order_relaxed);
+   memset(SectorBuffers, 0, sizeof(SectorBuffers));
+
+   ReqSerialPos       = 0;
+   Stats_Hits         = 0;
+   Stats_Misses       = 0;
+   Stats_StallNS      = 0;
+   Stats_Seeks        = 0;
+   Stats_SectorsRead  = 0;
+   Stats_MaxDepth     = 0;
 
    UnrecoverableError = false;
 
    s.cdif_ptr = this;
 
    CDReadThread = sthread_create((void (*)(void*))ReadThreadStart_C, &s);
-   EmuThreadQueue.Read(&msg);
+   ssem_wait(SectorSem);
 }
 
 
 CDIF_MT::~CDIF_MT()
 {
-   bool thread_deaded_failed = false;
+   ExitRequested.store(true, std::memory_order_relaxed);
+   Request(LBA_Read_Maximum + 1);
 
-   ReadThreadQueue.Write(CDIF_Message(CDIF_MSG_DIEDIEDIE));
+   sthread_join(CDReadThread);
 
-   if(!thread_deaded_failed)
-      sthread_join(CDReadThread);
+   if(Stats_Hits || Stats_Misses)
+   {
+      log_cb(RETRO_LOG_INFO, "CD read thread: %llu hits, %llu misses, stalled %.3f s total; read %llu sectors, %llu seeks, read-ahead depth max %d.\n",
+            (unsigned long long)Stats_Hits, (unsigned long long)Stats_Misses, Stats_StallNS / 1e9,
+            (unsigned long long)Stats_SectorsRead, (unsigned long long)Stats_Seeks, Stats_MaxDepth);
+   }
 
-   if(SBMutex)
+   if(ReadWakeupSem)
    {
-      slock_free(SBMutex);
-      SBMutex = NULL;
+      ssem_free(ReadWakeupSem);
+      ReadWakeupSem = NULL;
    }
 
-   if(SBCond)
+   if(SectorSem)
    {
-      scond_free(SBCond);
-      SBCond = NULL;
+      ssem_free(SectorSem);
+      SectorSem = NULL;
    }
 
    if (disc_cdaccess)
@@ -405,10 +329,37 @@ bool CDIF::ValidateRawSector(uint8_t *buf)
    return(true);
 }
 
+void CDIF_MT::Request(int32_t lba)
+{
+   ReqLBA.store(lba, std::memory_order_relaxed);
+   ReqSerialPos++;
+   ReqSerial.store(ReqSerialPos, std::memory_order_seq_cst);
+
+   if(ReadParked.load(std::memory_order_seq_cst) && ReadParked.exchange(false, std::memory_order_seq_cst))
+      ssem_signal(ReadWakeupSem);
+}
+
+/* Waits for the read thread to put more sectors in the ring than "written". */
+void CDIF_MT::WaitSector(uint32_t written)
+{
+   for(unsigned i = 0; i < SpinCount && SBWritten.load(std::memory_order_acquire) == written; i++)
+      CDIF_CPURelax();
+
+   while(SBWritten.load(std::memory_order_acquire) == written)
+   {
+      SectorWaiting.store(true, std::memory_order_seq_cst);
+
+      if(SBWritten.load(std::memory_order_seq_cst) == written || !SectorWaiting.exchange(false, std::memory_order_seq_cst))
+         ssem_wait(SectorSem);
+   }
+}
+
 bool CDIF_MT::ReadRawSector(uint8_t *buf, int32_t lba)
 {
-   bool found = false;
-   bool error_condition = false;
+   uint32_t read_pos;
+   uint32_t written;
+   bool missed = false;
+   std::chrono::steady_clock::time_point stall_start;
 
    if(UnrecoverableError)
    {
@@ -422,29 +373,48 @@ bool CDIF_MT::ReadRawSector(uint8_t *buf, int32_t lba)
       return(false);
    }
 
-   ReadThreadQueue.Write(CDIF_Message(CDIF_MSG_READ_SECTOR, lba));
-
-   slock_lock(SBMutex);
+   read_pos = SBRead.load(std::memory_order_relaxed);
+   written = SBWritten.load(std::memory_order_acquire);
 
-   do
+   for(;;)
    {
-      for(int i = 0; i < SBSize; i++)
+      for(uint32_t i = read_pos; i != written; i++)
       {
-         if(SectorBuffers[i].valid && SectorBuffers[i].lba == lba)
+         const CDIF_Sector_Buffer *sb = &SectorBuffers[i & (SBSize - 1)];
+
+         if(sb->lba == lba)
          {
-            error_condition = SectorBuffers[i].error;
-            memcpy(buf, SectorBuffers[i].data, 2352 + 96);
-            found = true;
+            const bool error_condition = sb->error;
+
+            memcpy(buf, sb->data, 2352 + 96);
+
+            /* Keep this sector around in case it's read again, but nothing before it. */
+            SBRead.store(i, std::memory_order_release);
+            Request(lba);
+
+            if(!missed)
+               Stats_Hits++;
+            else
+               Stats_StallNS += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - stall_start).count();
+
+            return(!error_condition);
          }
       }
 
-      if(!found)
-         scond_wait((scond_t*)SBCond, (slock_t*)SBMutex);
-   } while(!found);
-
-   slock_unlock(SBMutex);
+      if(!missed)
+      {
+         /* Not read(yet); anything in the ring now is from before a seek. */
+         missed = true;
+         Stats_Misses++;
+         stall_start = std::chrono::steady_clock::now();
+         SBRead.store(written, std::memory_order_release);
+         Request(lba);
+      }
 
-   return(!error_condition);
+      read_pos = written;
+      WaitSector(written);
+      written = SBWritten.load(std::memory_order_acquire);
+   }
 }
 
 bool CDIF_MT::ReadRawSectorPWOnly(uint8_t* pwbuf, int32_t lba, bool hint_fullread)
@@ -464,7 +434,7 @@ bool CDIF_MT::ReadRawSectorPWOnly(uint8_t* pwbuf, int32_t lba, bool hint_fullrea
    if(disc_cdaccess->Fast_Read_Raw_PW_TSRE(pwbuf, lba))
    {
       if(hint_fullread)
-         ReadThreadQueue.Write(CDIF_Message(CDIF_MSG_READ_SECTOR, lba));
+         Request(lba);
 
       return(true);
    }
@@ -485,7 +455,7 @@ void CDIF_MT::HintReadSector(int32_t lba)
    if(UnrecoverableError)
       return;
 
-   ReadThreadQueue.Write(CDIF_Message(CDIF_MSG_READ_SECTOR, lba));
+   Request(lba);
 }
 
 int CDIF::ReadSector(uint8_t* buf, int32_t lba, uint32_t sector_count, bool suppress_uncorrectable_message)
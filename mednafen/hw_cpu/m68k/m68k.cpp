@@ -74,9 +74,25 @@ M68K::M68K(const bool rev_e) : Revision_E(rev_e),
  timestamp = 0;
  XPending = 0;
  IPL = 0;
+ memset(FetchMap, 0, sizeof(FetchMap));
+ FetchCycles = 0;
  Reset(true);
 }
 
+void M68K::SetFetchMap(uint32 Astart, uint32 Aend, const uint16* ptr, uint32 length, unsigned cycles)
+{
+ assert(!(Astart & 0xFFFF) && (Aend & 0xFFFF) == 0xFFFF && !(length & 0xFFFF));
+ assert(!ptr || !FetchCycles || FetchCycles == cycles);
+
+ for(uint32 A = Astart; A <= Aend && A < 0x1000000; A += 0x10000)
+ {
+  FetchMap[A >> 16] = ptr ? (uintptr_t)ptr + ((A - Astart) % length) : 0;
+ }
+
+ if(ptr)
+  FetchCycles = cycles;
+}
+
 M68K::~M68K()
 {
 
@@ -196,9 +212,17 @@ INLINE T M68K::Read(uint32 addr)
 
 INLINE uint16 M68K::ReadOp(void)
 {
+ const uintptr_t fm = FetchMap[(PC >> 16) & 0xFF];
  uint16 ret;
 
- ret = BusReadInstr(PC);
+ if(MDFN_LIKELY(fm))
+ {
+  ret = ne16_rbo_be<uint16>(fm, PC & 0xFFFF);
+  timestamp += FetchCycles;
+ }
+ else
+  ret = BusReadInstr(PC);
+
  PC += 2;
 
  return ret;
@@ -42,6 +42,14 @@ class M68K
  void SetIPL(uint8 ipl_new);
  void SetExtHalted(bool state);
 
+ //
+ // Maps [Astart, Aend](in 64KiB units of the 24-bit address space) so that instruction fetches read the 16-bit words
+ // at "ptr"(repeating every "length" bytes) directly, adding "cycles" to timestamp, instead of calling BusReadInstr().
+ // Only for memory where BusReadInstr() would do exactly that, with no other side effects; pass nullptr to
+ // restore fetching through BusReadInstr().
+ //
+ void SetFetchMap(uint32 Astart, uint32 Aend, const uint16* ptr, uint32 length, unsigned cycles) MDFN_COLD;
+
  void StateAction(StateMem* sm, const unsigned load, const bool data_only, const char* sname);
 
  void LoadOldState(const uint8* osm);
@@ -74,6 +82,9 @@ class M68K
 
  uint32 SP_Inactive;
  uint32 XPending;
+
+ uintptr_t FetchMap[256];	// 0 for pages fetched through BusReadInstr()
+ uint32 FetchCycles;
  enum
  {
   XPENDING_MASK_INT 	= 0x0001,
@@ -34,6 +34,11 @@ uint64_t MDFN_GetSettingUI(const char *name)
       return setting_smpc_autortc_lang;
    if (!strcmp("ss.dbg_mask", name))
       return 1;
+   /* CDROM */
+   if (!strcmp("cdrom.chd.hunk_cache", name))
+      return setting_chd_hunk_cache;
+   if (!strcmp("cdrom.chd.decode_threads", name))
+      return setting_chd_decode_threads;
    return 0;
 }
 
@@ -0,0 +1,226 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* PolyphaseResampler.cpp - Polyphase windowed-sinc audio resampler
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#include "PolyphaseResampler.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static uint32 GCD(uint32 a, uint32 b)
+{
+ while(b)
+ {
+  const uint32 t = a % b;
+
+  a = b;
+  b = t;
+ }
+
+ return a;
+}
+
+// Zeroth-order modified Bessel function of the first kind, for the Kaiser window.
+static double BesselI0(const double x)
+{
+ double sum = 1.0;
+ double term = 1.0;
+
+ for(unsigned k = 1; k < 64; k++)
+ {
+  const double t = x / (2 * k);
+
+  term *= t * t;
+  sum += term;
+
+  if(term < sum * 1e-17)
+   break;
+ }
+
+ return sum;
+}
+
+PolyphaseResampler::PolyphaseResampler(const uint32 input_rate, const uint32 output_rate)
+{
+ const uint32 g = GCD(input_rate, output_rate);
+
+ assert(input_rate && output_rate && output_rate * 4 >= input_rate);
+
+ L = output_rate / g;
+ M = input_rate / g;
+ PosStep = M / L;
+ PhaseStep = M % L;
+
+ CoeffsAlloc = new int16[L * NumTaps + 8];
+ Coeffs = (int16*)(((uintptr_t)CoeffsAlloc + 15) &~ (uintptr_t)15);
+ //
+ // -6dB point a little below the lower of the two Nyquist frequencies, in cycles per input sample; with 64 taps and
+ // beta = 8(about 80dB of stopband attenuation), the transition band is about 0.08 wide.
+ //
+ const double cutoff = 0.5 * 0.92 * std::min<double>(1.0, (double)L / M);
+ const double beta = 8.0;
+ const double i0_beta = BesselI0(beta);
+
+ for(uint32 phase = 0; phase < L; phase++)
+ {
+  double h[NumTaps];
+  double sum = 0;
+
+  //
+  // Tap j applies to the input frame j frames older than the newest one, at a distance of j + phase / L input
+  // frames before the output frame.
+  //
+  for(uint32 j = 0; j < NumTaps; j++)
+  {
+   const double t = j + (double)phase / L - NumTaps / 2;
+   const double x = 2 * cutoff * t;
+   const double sinc = (fabs(x) < 1e-9) ? 1.0 : sin(M_PI * x) / (M_PI * x);
+   const double r = t / (NumTaps / 2);
+   const double window = (fabs(r) >= 1.0) ? 0.0 : BesselI0(beta * sqrt(1.0 - r * r)) / i0_beta;
+
+   h[j] = sinc * window;
+   sum += h[j];
+  }
+  //
+  // Normalize each phase to unity DC gain, putting the rounding error on the largest tap.
+  //
+  int16* const c = &Coeffs[phase * NumTaps];
+  int32 isum = 0;
+  uint32 largest = 0;
+
+  for(uint32 j = 0; j < NumTaps; j++)
+  {
+   const int32 v = (int32)floor(h[j] * 32768 / sum + 0.5);
+
+   c[NumTaps - 1 - j] = v;
+   isum += v;
+
+   if(fabs(h[j]) > fabs(h[largest]))
+    largest = j;
+  }
+
+  c[NumTaps - 1 - largest] += 32768 - isum;
+ }
+
+ Reset();
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+ delete[] CoeffsAlloc;
+}
+
+void PolyphaseResampler::Reset(void)
+{
+ memset(Buf, 0, sizeof(Buf));
+ Phase = 0;
+ Pos = NumTaps - 1;
+ BufCount = NumTaps - 1;
+}
+
+uint32 PolyphaseResampler::MaxOutputFrames(const uint32 in_frames) const
+{
+ return (uint32)(((uint64)in_frames * L + M - 1) / M) + 1;
+}
+
+static INLINE int16 Filter(const int16* x, const int16* c, const unsigned count)
+{
+ int32 acc;
+
+#if defined(__SSE2__)
+ __m128i sum = _mm_setzero_si128();
+
+ for(unsigned i = 0; i < count; i += 8)
+  sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_loadu_si128((const __m128i*)&x[i]), _mm_load_si128((const __m128i*)&c[i])));
+
+ sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+ sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+ acc = _mm_cvtsi128_si32(sum);
+#else
+ acc = 0;
+
+ for(unsigned i = 0; i < count; i++)
+  acc += x[i] * c[i];
+#endif
+
+ acc = (acc + 16384) >> 15;
+
+ return std::min<int32>(32767, std::max<int32>(-32768, acc));
+}
+
+uint32 PolyphaseResampler::Process(const int16* in, uint32 in_frames, int16* out)
+{
+ uint32 ret = 0;
+
+ while(in_frames)
+ {
+  //
+  // Drop input that no later output frame depends on.
+  //
+  const uint32 discard = Pos - (NumTaps - 1);
+
+  if(discard)
+  {
+   for(unsigned ch = 0; ch < 2; ch++)
+    memmove(&Buf[ch][0], &Buf[ch][discard], (BufCount - discard) * sizeof(int16));
+
+   BufCount -= discard;
+   Pos -= discard;
+  }
+
+  const uint32 n = std::min<uint32>(in_frames, NumTaps + BlockFrames - BufCount);
+
+  for(uint32 i = 0; i < n; i++)
+  {
+   Buf[0][BufCount + i] = in[i * 2 + 0];
+   Buf[1][BufCount + i] = in[i * 2 + 1];
+  }
+
+  BufCount += n;
+  in += n * 2;
+  in_frames -= n;
+
+  while(Pos < BufCount)
+  {
+   const int16* c = &Coeffs[Phase * NumTaps];
+
+   out[0] = Filter(&Buf[0][Pos + 1 - NumTaps], c, NumTaps);
+   out[1] = Filter(&Buf[1][Pos + 1 - NumTaps], c, NumTaps);
+   out += 2;
+   ret++;
+
+   Pos += PosStep;
+   Phase += PhaseStep;
+
+   if(Phase >= L)
+   {
+    Phase -= L;
+    Pos++;
+   }
+  }
+ }
+
+ return ret;
+}
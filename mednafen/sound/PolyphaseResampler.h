@@ -0,0 +1,63 @@
+/******************************************************************************/
+/* Mednafen - Multi-system Emulator                                           */
+/******************************************************************************/
+/* PolyphaseResampler.h - Polyphase windowed-sinc audio resampler
+**
+** This program is free software; you can redistribute it and/or
+** modify it under the terms of the GNU General Public License
+** as published by the Free Software Foundation; either version 2
+** of the License, or (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software Foundation, Inc.,
+** 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+*/
+
+#ifndef __MDFN_SOUND_POLYPHASERESAMPLER_H
+#define __MDFN_SOUND_POLYPHASERESAMPLER_H
+
+#include "../mednafen-types.h"
+
+//
+// Converts interleaved 16-bit stereo between two fixed rates whose ratio reduces to L/M, using a bank of L 64-tap
+// Kaiser-windowed sinc filters(one per output phase) with 16-bit coefficients.  Output rate must be at least a quarter
+// of the input rate.
+//
+class PolyphaseResampler
+{
+ public:
+
+ PolyphaseResampler(const uint32 input_rate, const uint32 output_rate) MDFN_COLD;
+ ~PolyphaseResampler() MDFN_COLD;
+
+ void Reset(void) MDFN_COLD;
+
+ // Upper bound on what Process() will return for "in_frames" input frames.
+ uint32 MaxOutputFrames(const uint32 in_frames) const;
+
+ // Returns the number of frames written to "out".
+ uint32 Process(const int16* in, uint32 in_frames, int16* out);
+
+ private:
+
+ enum : uint32 { NumTaps = 64 };	// Multiple of 8
+ enum : uint32 { BlockFrames = 1024 };
+
+ uint32 L, M;
+ uint32 PosStep, PhaseStep;
+
+ int16* Coeffs;	// [L][NumTaps], each phase's taps reversed to line up with the input.
+ int16* CoeffsAlloc;
+
+ uint32 Phase;	// Of the next output frame, 0 to L - 1.
+ uint32 Pos;	// Index in Buf of the newest input frame the next output frame depends on.
+ uint32 BufCount;
+ alignas(16) int16 Buf[2][NumTaps + BlockFrames];
+};
+
+#endif
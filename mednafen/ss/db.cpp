@@ -186,9 +186,25 @@ static const struct
  { "T-4507G", HORRIBLEHACK_VDP1VRAM5000FIX } // "Grandia (Japan)", gettext_noop("Fixes hang at end of first disc.") },
 };
 
+//
+// SH-2 idle loop skipping compatibility.
+//
+static const struct
+{
+ const char* sgid;
+ unsigned mode;
+ uint8 fd_id[16];
+} isdb[] =
+{
+ // Rely on instruction timing to mask interrupt handler races(see notes/PROBLEMATIC-GAMES).
+ { "T-1230G",	IDLESKIP_DENY },	// Pocket Fighter (Japan)
+ { "T-1210G",	IDLESKIP_DENY },	// Street Fighter Zero 2 (Japan)
+ { "T-1210H",	IDLESKIP_DENY },	// Street Fighter Alpha 2 (USA)
+};
+
 void DB_Lookup(const char* path, const char* sgid, const uint8* fd_id,
  unsigned* const region, int* const cart_type, unsigned* const cpucache_emumode,
- unsigned* const hhv)
+ unsigned* const hhv, unsigned* const idleskip)
 {
  for(auto& re : regiondb)
  {
@@ -225,5 +241,14 @@ void DB_Lookup(const char* path, const char* sgid, const uint8* fd_id,
    break;
   }
  }
+
+ for(auto& is : isdb)
+ {
+  if((is.sgid && !strcmp(is.sgid, sgid)) || (!is.sgid && !memcmp(is.fd_id, fd_id, 16)))
+  {
+   *idleskip = is.mode;
+   break;
+  }
+ }
 }
 
@@ -29,7 +29,14 @@ enum
  CPUCACHE_EMUMODE_FULL
 };
 
-void DB_Lookup(const char* path, const char* sgid, const uint8* fd_id, unsigned* const region, int* const cart_type, unsigned* const cpucache_emumode, unsigned* const hhv);
+enum
+{
+ IDLESKIP_DEFAULT,
+ IDLESKIP_ALLOW,	// Known to work with SH-2 idle loop skipping.
+ IDLESKIP_DENY		// Known to break with SH-2 idle loop skipping.
+};
+
+void DB_Lookup(const char* path, const char* sgid, const uint8* fd_id, unsigned* const region, int* const cart_type, unsigned* const cpucache_emumode, unsigned* const hhv, unsigned* const idleskip);
 
 #endif
 
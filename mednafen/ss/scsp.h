@@ -44,6 +44,11 @@ class SS_SCSP
   return RAM;
  }
 
+ INLINE uint8* GetRAMDirtyMap(void)
+ {
+  return RAMDirty;
+ }
+
  enum
  {
   GSREG_MVOL = 0,
@@ -134,8 +139,6 @@ class SS_SCSP
   uint8 ToDSPSelect;
   uint8 ToDSPLevel;
 
-  int16 DirectVolume[2];	// 1.14 fixed point, derived from DISDL and DIPAN
-  int16 EffectVolume[2];	// 1.14 fixed point, derived from EFSDL and EFPAN
   //
   //
   uint32 PhaseWhacker;
@@ -149,10 +152,29 @@ class SS_SCSP
 
   uint8 LFOCounter;
   uint16 LFOTimeCounter;
+
+  uint32 SilentSince;	// GlobalCounter value at the last full RunSample() pass over the slot, while in SilentSlots.
  } Slots[32];
 
+ //
+ // Bit n is set while slot n is silent(released, at maximum attenuation, and only able to produce 0 samples); RunSample()
+ // then skips its EG, LFO, and address generation, and WakeSlots() brings that state back up to date before anything
+ // can observe or change it.
+ //
+ uint32 SilentSlots;
+ void WakeSlots(uint32 mask);
+
+ //
+ // Per-channel, per-slot volumes, laid out for SCSP_MixChannels().
+ //
+ alignas(16) int16 DirectVolume[2][32];	// 1.14 fixed point, derived from DISDL and DIPAN
+ alignas(16) int16 EffectVolume[2][32];	// 1.14 fixed point, derived from EFSDL and EFPAN
+ alignas(16) int16 SlotOut[32];		// Direct output of each slot for the current sample.
+
  uint16 EXTS[2];
 
+ unsigned CalcKeyEGScale(const Slot* s);
+ bool SlotIsSilent(const Slot* s);
  void RunEG(Slot* s, const unsigned key_eg_scale);
 
  uint8 GetALFO(Slot* s);
@@ -305,10 +327,57 @@ class SS_SCSP
 
   bool MPROG_Dirty;
  } DSP;
+
+#ifndef MDFN_SS_SCSP_DSP_DYNAREC
+ enum
+ {
+  DSPSTEP_NXADDR	= 1U <<  0,
+  DSPSTEP_ADRGB		= 1U <<  1,
+  DSPSTEP_NOFL		= 1U <<  2,
+  DSPSTEP_BSEL		= 1U <<  3,
+  DSPSTEP_ZERO		= 1U <<  4,
+  DSPSTEP_NEGB		= 1U <<  5,
+  DSPSTEP_YRL		= 1U <<  6,
+  DSPSTEP_SHFT01	= 1U <<  7,	// SHFT0 and SHFT1 both set
+  DSPSTEP_SATURATE	= 1U <<  8,	// SHFT1 clear
+  DSPSTEP_FRCL		= 1U <<  9,
+  DSPSTEP_ADRL		= 1U << 10,
+  DSPSTEP_EWT		= 1U << 11,
+  DSPSTEP_MRT		= 1U << 12,
+  DSPSTEP_MWT		= 1U << 13,
+  DSPSTEP_TABLE		= 1U << 14,
+  DSPSTEP_IWT		= 1U << 15,
+  DSPSTEP_XSEL		= 1U << 16,
+  DSPSTEP_TWT		= 1U << 17,
+
+  DSPSTEP_SHIFTER	= 1U << 18,	// Shifter output is used.
+  DSPSTEP_SFT_USED	= 1U << 19,	// SFT_REG result is read before being overwritten.
+  DSPSTEP_ADDR_USED	= 1U << 20,	// RWAddr result is read before being overwritten.
+ };
+
+ struct DSPStep
+ {
+  uint32 Flags;
+  uint8 ShiftAmount;
+  uint8 MASA;
+  uint8 CRA;
+  uint8 EWA;
+  uint8 IWA;
+  uint8 IRA;
+  uint8 YSEL;
+  uint8 TWA;
+  uint8 TRA;
+ };
+
+ DSPStep DSPSteps[0x80];
+ unsigned DSPStepCount;
+ void DecodeDSP(void);
+#endif
  //
  //
 
  uint16 RAM[262144 * 2];	// *2 for dummy so we don't have to have so many conditionals in the playback code.
+ uint8 RAMDirty[(262144 * sizeof(uint16)) >> SS_PAGE_SHIFT];	// For the rewind ring.
 
 #ifdef MDFN_SS_SCSP_DSP_DYNAREC
  alignas(8) uint8 DynaRecPool[65536];
@@ -438,6 +438,15 @@ class SH7095 final
  template<unsigned which, bool EmulateICache, int DebugMode>
  INLINE void UCRelDelayBranch(uint32 disp);
 
+ //
+ // Idle(polling) loop detection, only used when instruction cache emulation is disabled.
+ //
+ bool IdleSkip;
+ enum { IDLE_LOOP_MAX_INSTR = 8 };
+ uint32 IdleRejectPC;	// Branch address of the most recent loop rejected based on its instructions alone.
+ sscpu_timestamp_t IdleSyncTS;	// Nonzero while the master is idle and running the slave up to this time.
+
+ NO_INLINE void IdleLoopCheck(const uint32 target, const uint32 bpc, const bool delayed);
 
  //
  //
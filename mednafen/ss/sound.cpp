@@ -56,20 +56,53 @@ static INLINE void SCSP_MainIntChanged(bool state)
 
 #include "scsp.inc"
 
-static NO_INLINE void RunSCSP(void)
+// p[i] = (p[i] * 27 + 16) >> 5
+static INLINE void ScaleOutput(int16* p, const uint32 count)
 {
- CDB_GetCDDA(SCSP.GetEXTSPtr());
- //
- //
- int16* const bp = IBuffer[IBufferCount];
- SCSP.RunSample(bp);
- //bp[0] = rand();
- //bp[1] = rand();
- bp[0] = (bp[0] * 27 + 16) >> 5;
- bp[1] = (bp[1] * 27 + 16) >> 5;
-
- IBufferCount = (IBufferCount + 1) & 1023;
- next_scsp_time += 256;
+ uint32 i = 0;
+
+#if defined(__SSE2__)
+ const __m128i mul = _mm_set1_epi16(27);
+ const __m128i bias = _mm_set1_epi32(16);
+
+ for(; (i + 8) <= count; i += 8)
+ {
+  const __m128i v = _mm_loadu_si128((const __m128i*)&p[i]);
+  const __m128i lo = _mm_mullo_epi16(v, mul);
+  const __m128i hi = _mm_mulhi_epi16(v, mul);
+  const __m128i r0 = _mm_srai_epi32(_mm_add_epi32(_mm_unpacklo_epi16(lo, hi), bias), 5);
+  const __m128i r1 = _mm_srai_epi32(_mm_add_epi32(_mm_unpackhi_epi16(lo, hi), bias), 5);
+
+  _mm_storeu_si128((__m128i*)&p[i], _mm_packs_epi32(r0, r1));
+ }
+#endif
+
+ for(; i < count; i++)
+  p[i] = (p[i] * 27 + 16) >> 5;
+}
+
+//
+// Renders the next "count" samples into IBuffer in as few spans as the ring buffer allows.
+//
+static NO_INLINE void RunSCSP(uint32 count = 1)
+{
+ while(count)
+ {
+  const uint32 span = std::min<uint32>(count, 1024 - IBufferCount);
+  int16 (*const bp)[2] = &IBuffer[IBufferCount];
+
+  for(uint32 i = 0; i < span; i++)
+  {
+   CDB_GetCDDA(SCSP.GetEXTSPtr());
+   SCSP.RunSample(bp[i]);
+  }
+
+  ScaleOutput(bp[0], span * 2);
+
+  IBufferCount = (IBufferCount + span) & 1023;
+  next_scsp_time += 256 * span;
+  count -= span;
+ }
 }
 
 static MDFN_FASTCALL uint8 SoundCPU_BusRead_uint8(uint32 A)
@@ -198,6 +231,11 @@ void SOUND_Init(void)
 
  SoundCPU.BusReadInstr = SoundCPU_BusReadInstr;
 
+ // Instruction fetches from sound RAM(and its mirrors) cost the same 6 cycles as SoundCPU_BusReadInstr() and never
+ // sync the SCSP, so the 68K reads them straight from RAM.
+ for(uint32 A = 0; A < 0x1000000; A += 0x200000)
+  SoundCPU.SetFetchMap(A, A + 0x7FFFF, SCSP.GetRAMPtr(), 0x80000, 6);
+
  SoundCPU.BusRMW = SoundCPU_BusRMW;
 
  SoundCPU.BusIntAck = SoundCPU_BusIntAck;
@@ -207,6 +245,7 @@ void SOUND_Init(void)
  SoundCPU.DBG_Verbose = SS_DBG_Wrap<SS_DBG_M68K>;
 
  SS_SetPhysMemMap(0x05A00000, 0x05A7FFFF, SCSP.GetRAMPtr(), 0x80000, true);
+ MDFNSS_TrackDirty(SCSP.GetRAMPtr(), 0x80000, SCSP.GetRAMDirtyMap());
  // TODO: MEM4B: SS_SetPhysMemMap(0x05A00000, 0x05AFFFFF, SCSP.GetRAMPtr(), 0x40000, true);
 }
 
@@ -218,6 +257,7 @@ uint8 SOUND_PeekRAM(uint32 A)
 void SOUND_PokeRAM(uint32 A, uint8 V)
 {
  ne16_wbo_be<uint8>(SCSP.GetRAMPtr(), A & 0x7FFFF, V);
+ SS_MarkDirty(SCSP.GetRAMDirtyMap(), A & 0x7FFFF);
 }
 
 void SOUND_ResetTS(void)
@@ -294,8 +334,10 @@ sscpu_timestamp_t SOUND_Update(sscpu_timestamp_t timestamp)
  }
  else
  {
-  while(next_scsp_time < (run_until_time >> 32))
-   RunSCSP();
+  const int32 until = run_until_time >> 32;
+
+  if(next_scsp_time < until)
+   RunSCSP((until - next_scsp_time + 255) >> 8);
  }
 
  return timestamp + 128;	// FIXME
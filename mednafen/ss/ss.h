@@ -93,6 +93,7 @@
  extern int32 SH7095_mem_timestamp;
 
  void SS_RequestMLExit(void);
+ void SS_InvalidateStateSize(void);	// After anything that changes the save state layout.
  void ForceEventUpdates(const sscpu_timestamp_t timestamp);
 
  enum
@@ -127,8 +128,8 @@ typedef sscpu_timestamp_t (*ss_event_handler)(const sscpu_timestamp_t timestamp)
  struct event_list_entry
  {
   sscpu_timestamp_t event_time;
-  event_list_entry *prev;
-  event_list_entry *next;
+  uint32 heap_index;
+  uint32 order;	// Tiebreaker for events with the same event_time; see events.inc
   ss_event_handler event_handler;
  };
 
@@ -137,6 +138,19 @@ typedef sscpu_timestamp_t (*ss_event_handler)(const sscpu_timestamp_t timestamp)
  #define SS_EVENT_DISABLED_TS			0x40000000
  void SS_SetEventNT(event_list_entry* e, const sscpu_timestamp_t next_timestamp);
 
+ //
+ // Host time spent in each event handler, and in emulating whole frames, accumulated only while SS_ProfileActive
+ // is set(see bench/core_bench.cpp).
+ //
+ struct SS_ProfileData
+ {
+  uint64 event_ns[SS_EVENT__COUNT];
+  uint64 emulate_ns;
+ };
+
+ extern bool SS_ProfileActive;
+ extern SS_ProfileData SS_Profile;
+
  // Call from init code, or power/reset code, as appropriate.
  // (length is in units of bytes, not 16-bit units)
  //
@@ -39,6 +39,13 @@
 
 #include "../FileStream.h"
 
+#include <retro_timers.h>
+#include <rthreads/rthreads.h>
+#include <rthreads/rsemaphore.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+
 enum : int { VDP1_UpdateTimingGran = 263 };
 enum : int { VDP1_IdleTimingGran = 1019 };
 
@@ -50,6 +57,7 @@ line_data LineSetup;
 uint8 gouraud_lut[0x40];
 
 uint16 VRAM[0x40000];
+uint8 VRAM_Dirty[sizeof(VRAM) >> SS_PAGE_SHIFT];	// For the rewind ring; the framebuffers are compared instead.
 uint16 FB[2][0x20000];
 bool FBDrawWhich;
 
@@ -100,6 +108,196 @@ static int32 CycleCounter;
 
 static bool vbcdpending;
 
+//
+// Draw thread.
+//
+// With the draw thread enabled, commands are still fetched, set up and timed on the emulation thread, in Update(), but
+// the lines they're made of are drawn later, on the draw thread, from copies of LineSetup queued by
+// DrawThread_QueueLine()(see CallLineFn() in vdp1_common.h).  Queued lines read VRAM and FB[FBDrawWhich], so the
+// emulation thread waits for the draw thread to catch up with DrawThread_Sync() before writing VRAM, accessing the
+// framebuffer being drawn to, swapping framebuffers, resetting, and saving or loading state.  GetLine() and the
+// framebuffer erases only touch the framebuffer being displayed, so they don't need to wait.
+//
+// The emulation thread(in DrawThread_WaitIdle()) and the draw thread(when it runs out of lines) each spin for a
+// little while before blocking on a semaphore; see the comments on VDP2REND_WAIT_SPIN_PARK in vdp2_render.cpp for how
+// wakeups are kept from being missed.
+//
+enum : uint32 { DT_QUEUE_SIZE = 0x1000 };	// Power of 2
+enum : unsigned { DT_SPIN_COUNT = 0x400 };
+
+struct DT_Entry
+{
+ line_fn fn;	// NULL to make the draw thread exit.
+ line_data ls;
+};
+
+bool DrawThreadEnabled;
+static sthread_t* DT_Thread;
+static ssem_t* DT_WakeupSem;
+static ssem_t* DT_IdleSem;
+static std::array<DT_Entry, DT_QUEUE_SIZE> DT_Queue;
+static uint32 DT_WritePos;			// Free-running; emulation thread's copy of DT_Written.
+static std::atomic_uint_least32_t DT_Written;	// Free-running count of entries queued.
+static std::atomic_uint_least32_t DT_Read;	// Free-running count of entries done.
+static std::atomic_bool DT_Parked;
+static std::atomic_bool DT_IdleWaiting;
+
+static uint64 DT_Stats_Lines, DT_Stats_Syncs, DT_Stats_SyncWaitNS;
+
+static INLINE void DT_CPURelax(void)
+{
+#if defined(_MSC_VER)
+ __nop();
+#elif defined(__i386__) || defined(__x86_64__)
+ asm volatile("pause");
+#elif defined(__aarch64__)
+ asm volatile("yield");
+#else
+ std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+static void DrawThreadEntry(void* data)
+{
+ uint32 read_pos = DT_Read.load(std::memory_order_relaxed);
+
+ for(;;)
+ {
+  if(read_pos == DT_Written.load(std::memory_order_acquire))
+  {
+   for(unsigned i = 0; i < DT_SPIN_COUNT && read_pos == DT_Written.load(std::memory_order_acquire); i++)
+    DT_CPURelax();
+
+   if(read_pos == DT_Written.load(std::memory_order_acquire))
+   {
+    DT_Parked.store(true, std::memory_order_seq_cst);
+
+    if(read_pos == DT_Written.load(std::memory_order_seq_cst) || !DT_Parked.exchange(false, std::memory_order_seq_cst))
+     ssem_wait(DT_WakeupSem);
+
+    DT_Parked.store(false, std::memory_order_relaxed);
+    continue;
+   }
+  }
+
+  DT_Entry* const e = &DT_Queue[read_pos & (DT_QUEUE_SIZE - 1)];
+
+  if(!e->fn)
+   break;
+
+  e->fn(&e->ls);
+  read_pos++;
+  DT_Read.store(read_pos, std::memory_order_seq_cst);
+
+  if(read_pos == DT_Written.load(std::memory_order_acquire) && DT_IdleWaiting.load(std::memory_order_seq_cst))
+  {
+   if(DT_IdleWaiting.exchange(false, std::memory_order_seq_cst))
+    ssem_signal(DT_IdleSem);
+  }
+ }
+}
+
+static void DT_Put(const line_fn fn)
+{
+ if(MDFN_UNLIKELY((DT_WritePos - DT_Read.load(std::memory_order_acquire)) == DT_QUEUE_SIZE))
+ {
+  do
+  {
+   retro_sleep(0);
+  } while((DT_WritePos - DT_Read.load(std::memory_order_acquire)) == DT_QUEUE_SIZE);
+ }
+
+ DT_Entry* const e = &DT_Queue[DT_WritePos & (DT_QUEUE_SIZE - 1)];
+
+ e->fn = fn;
+ e->ls = LineSetup;
+
+ DT_WritePos++;
+ DT_Written.store(DT_WritePos, std::memory_order_seq_cst);
+
+ if(DT_Parked.load(std::memory_order_seq_cst) && DT_Parked.exchange(false, std::memory_order_seq_cst))
+  ssem_signal(DT_WakeupSem);
+}
+
+void DrawThread_QueueLine(line_fn draw_fn)
+{
+ DT_Put(draw_fn);
+ DT_Stats_Lines++;
+}
+
+static NO_INLINE void DrawThread_WaitIdle(void)
+{
+ const auto start_time = std::chrono::steady_clock::now();
+
+ for(unsigned i = 0; i < DT_SPIN_COUNT && DT_Read.load(std::memory_order_acquire) != DT_WritePos; i++)
+  DT_CPURelax();
+
+ while(DT_Read.load(std::memory_order_acquire) != DT_WritePos)
+ {
+  DT_IdleWaiting.store(true, std::memory_order_seq_cst);
+
+  if(DT_Read.load(std::memory_order_seq_cst) != DT_WritePos || !DT_IdleWaiting.exchange(false, std::memory_order_seq_cst))
+   ssem_wait(DT_IdleSem);
+ }
+
+ DT_Stats_Syncs++;
+ DT_Stats_SyncWaitNS += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+static INLINE void DrawThread_Sync(void)
+{
+ if(MDFN_UNLIKELY(DT_Read.load(std::memory_order_acquire) != DT_WritePos))
+  DrawThread_WaitIdle();
+}
+
+void SetDrawThread(const bool enable)
+{
+ if(enable == (DT_Thread != NULL))
+  return;
+
+ if(enable)
+ {
+  DT_WakeupSem = ssem_new(0);
+  DT_IdleSem = ssem_new(0);
+
+  if(!(DT_Thread = sthread_create(DrawThreadEntry, NULL)))
+  {
+   ssem_free(DT_IdleSem);
+   DT_IdleSem = NULL;
+   ssem_free(DT_WakeupSem);
+   DT_WakeupSem = NULL;
+   return;
+  }
+
+  DrawThreadEnabled = true;
+ }
+ else
+ {
+  DrawThread_Sync();
+  DT_Put(NULL);
+  sthread_join(DT_Thread);
+  DT_Thread = NULL;
+  //
+  // The exit entry was never marked done.
+  DT_WritePos--;
+  DT_Written.store(DT_WritePos, std::memory_order_relaxed);
+
+  ssem_free(DT_IdleSem);
+  DT_IdleSem = NULL;
+  ssem_free(DT_WakeupSem);
+  DT_WakeupSem = NULL;
+
+  DrawThreadEnabled = false;
+ }
+}
+
+void GetDrawThreadStats(DrawThreadStats* stats)
+{
+ stats->lines = DT_Stats_Lines;
+ stats->syncs = DT_Stats_Syncs;
+ stats->sync_wait_ns = DT_Stats_SyncWaitNS;
+}
+
 void Init(void)
 {
  vbcdpending = false;
@@ -118,21 +316,28 @@ void Init(void)
  //
  //
  SS_SetPhysMemMap(0x05C00000, 0x05C7FFFF, VRAM, sizeof(VRAM), true);
+ MDFNSS_TrackDirty(VRAM, sizeof(VRAM), VRAM_Dirty);
  //SS_SetPhysMemMap(0x05C80000, 0x05CFFFFF, FB[FBDrawWhich], sizeof(FB[0]), true);
 
  vb_status = false;
  hb_status = false;
  lastts = 0;
  FBVBEraseLastTS = 0;
+
+ DT_Stats_Lines = 0;
+ DT_Stats_Syncs = 0;
+ DT_Stats_SyncWaitNS = 0;
 }
 
 void Kill(void)
 {
-
+ SetDrawThread(false);
 }
 
 void Reset(bool powering_up)
 {
+ DrawThread_Sync();
+
  if(powering_up)
  {
   for(unsigned i = 0; i < 0x40000; i++)
@@ -229,9 +434,9 @@ int32 CMD_SetLocalCoord(const uint16* cmd_data)
 }
 
 template<unsigned ECDSPDMode>
-static uint32 MDFN_FASTCALL TexFetch(uint32 x)
+static uint32 MDFN_FASTCALL TexFetch(line_data* ls, uint32 x)
 {
- const uint32 base = LineSetup.tex_base;
+ const uint32 base = ls->tex_base;
  const bool ECD = ECDSPDMode & 0x10;
  const bool SPD = ECDSPDMode & 0x08;
  const unsigned ColorMode = ECDSPDMode & 0x07;
@@ -246,10 +451,10 @@ static uint32 MDFN_FASTCALL TexFetch(uint32 x)
 
 	if(!ECD && rtd == 0xF)
 	{
-	 LineSetup.ec_count--;	
+	 ls->ec_count--;	
 	 return -1;
 	}
-	ret_or = LineSetup.cb_or;
+	ret_or = ls->cb_or;
 	
 	if(!SPD) ret_or |= (int32)(rtd - 1) >> 31;
 
@@ -260,24 +465,24 @@ static uint32 MDFN_FASTCALL TexFetch(uint32 x)
 
 	if(!ECD && rtd == 0xF)
 	{
-	 LineSetup.ec_count--;
+	 ls->ec_count--;
 	 return -1;
 	}
 
 	if(!SPD) ret_or |= (int32)(rtd - 1) >> 31;
 
-	return LineSetup.CLUT[rtd] | ret_or;
+	return ls->CLUT[rtd] | ret_or;
 
   case 2:	// 64 colors, color bank
 	rtd = (VRAM[(base + (x >> 1)) & 0x3FFFF] >> (((x & 0x1) ^ 0x1) << 3)) & 0xFF;
 
 	if(!ECD && rtd == 0xFF)
 	{
-	 LineSetup.ec_count--;
+	 ls->ec_count--;
 	 return -1;
 	}
 
-	ret_or = LineSetup.cb_or;
+	ret_or = ls->cb_or;
 
 	if(!SPD) ret_or |= (int32)(rtd - 1) >> 31;
 
@@ -288,11 +493,11 @@ static uint32 MDFN_FASTCALL TexFetch(uint32 x)
 
 	if(!ECD && rtd == 0xFF)
 	{
-	 LineSetup.ec_count--;
+	 ls->ec_count--;
 	 return -1;
 	}
 
-	ret_or = LineSetup.cb_or;
+	ret_or = ls->cb_or;
 
 	if(!SPD) ret_or |= (int32)(rtd - 1) >> 31;
 
@@ -303,11 +508,11 @@ static uint32 MDFN_FASTCALL TexFetch(uint32 x)
 
 	if(!ECD && rtd == 0xFF)
 	{
-	 LineSetup.ec_count--;
+	 ls->ec_count--;
 	 return -1;
 	}
 
-	ret_or = LineSetup.cb_or;
+	ret_or = ls->cb_or;
 
 	if(!SPD) ret_or |= (int32)(rtd - 1) >> 31;
 
@@ -323,7 +528,7 @@ static uint32 MDFN_FASTCALL TexFetch(uint32 x)
 
 	if(!ECD && (rtd & 0xC000) == 0x4000)
 	{
-	 LineSetup.ec_count--;
+	 ls->ec_count--;
 	 return -1;
 	}
 
@@ -334,7 +539,7 @@ static uint32 MDFN_FASTCALL TexFetch(uint32 x)
 }
 
 
-extern uint32 (MDFN_FASTCALL *const TexFetchTab[0x20])(uint32 x) =
+extern uint32 (MDFN_FASTCALL *const TexFetchTab[0x20])(line_data* ls, uint32 x) =
 {
  #define TF(a) (TexFetch<a>)
 
@@ -425,6 +630,18 @@ sscpu_timestamp_t Update(sscpu_timestamp_t timestamp)
       CMD_SetUserClip, CMD_SetSystemClip,  CMD_SetLocalCoord, CMD_SetUserClip
      };
 
+     if(cc < 0x8)
+     {
+      LineSetup.SysClipX = SysClipX;
+      LineSetup.SysClipY = SysClipY;
+      LineSetup.UserClipX0 = UserClipX0;
+      LineSetup.UserClipY0 = UserClipY0;
+      LineSetup.UserClipX1 = UserClipX1;
+      LineSetup.UserClipY1 = UserClipY1;
+      LineSetup.FBCR = FBCR;
+      LineSetup.fb = FB[FBDrawWhich];
+     }
+
      CycleCounter -= command_table[cc](cmd_data);
     }
    }
@@ -553,9 +770,14 @@ void SetHBVB(const sscpu_timestamp_t event_timestamp, const bool new_hb_status,
    //
    if(!(FBCR & FBCR_FCM) || (FBManualPending && (FBCR & FBCR_FCT)))	// Swap framebuffers
    {
+    DrawThread_Sync();
+
 #if 1
     if((ss_horrible_hacks & HORRIBLEHACK_VDP1VRAM5000FIX) && DrawingActive && VRAM[0] == 0x5000 && VRAM[1] == 0x0000)
+    {
      VRAM[0] = 0x8000;
+     SS_MarkDirty(VRAM_Dirty, 0);
+    }
 #endif
 
     if(DrawingActive)
@@ -784,9 +1006,13 @@ void Write8_DB(uint32 A, uint16 DB)
 {
  A &= 0x1FFFFF;
 
+ if(A < 0x100000)
+  DrawThread_Sync();
+
  if(A < 0x80000)
  {
   ne16_wbo_be<uint8>(VRAM, A, DB >> (((A & 1) ^ 1) << 3) );
+  SS_MarkDirty(VRAM_Dirty, A);
   return;
  }
 
@@ -808,9 +1034,13 @@ void Write16_DB(uint32 A, uint16 DB)
 {
  A &= 0x1FFFFE;
 
+ if(A < 0x100000)
+  DrawThread_Sync();
+
  if(A < 0x80000)
  {
   VRAM[A >> 1] = DB;
+  SS_MarkDirty(VRAM_Dirty, A);
   return;
  }
 
@@ -839,6 +1069,8 @@ uint16 Read16_DB(uint32 A)
  {
   uint32 FBA = A;
 
+  DrawThread_Sync();
+
   if((TVMR & (TVMR_8BPP | TVMR_ROTATE)) == (TVMR_8BPP | TVMR_ROTATE))
    FBA = (FBA & 0x1FF) | ((FBA << 1) & 0x3FC00) | ((FBA >> 8) & 0x200);
 
@@ -850,6 +1082,8 @@ uint16 Read16_DB(uint32 A)
 
 void StateAction(StateMem* sm, const unsigned load, const bool data_only)
 {
+ DrawThread_Sync();
+
  SFORMAT StateRegs[] =
  {
   SFVAR(VRAM),
@@ -45,6 +45,18 @@ void SetHBVB(const sscpu_timestamp_t event_timestamp, const bool new_hb_status,
 
 bool GetLine(const int line, uint16* buf, unsigned w, uint32 rot_x, uint32 rot_y, uint32 rot_xinc, uint32 rot_yinc);
 
+// Draw command lines on a separate thread; output and timing are the same either way.
+void SetDrawThread(const bool enable) MDFN_COLD;
+
+// Cumulative since Init().
+struct DrawThreadStats
+{
+ uint64 lines;		// Lines queued to the draw thread.
+ uint64 syncs;		// Number of times the emulation thread had to wait for the draw thread.
+ uint64 sync_wait_ns;	// Time spent waiting.
+};
+void GetDrawThreadStats(DrawThreadStats* stats) MDFN_COLD;
+
 //
 //
 //
@@ -59,8 +71,10 @@ INLINE uint8 PeekVRAM(const uint32 addr)
 INLINE void PokeVRAM(const uint32 addr, const uint8 val)
 {
  extern uint16 VRAM[0x40000];
+ extern uint8 VRAM_Dirty[];
 
  ne16_wbo_be<uint8>(VRAM, addr & 0x7FFFF, val);
+ SS_MarkDirty(VRAM_Dirty, addr & 0x7FFFF);
 }
 
 INLINE uint8 PeekFB(const bool which, const uint32 addr)
@@ -43,7 +43,8 @@ extern int32 SysClipX, SysClipY;
 extern int32 UserClipX0, UserClipY0, UserClipX1, UserClipY1;
 extern int32 LocalX, LocalY;
 
-extern uint32 (MDFN_FASTCALL *const TexFetchTab[0x20])(uint32 x);
+struct line_data;
+extern uint32 (MDFN_FASTCALL *const TexFetchTab[0x20])(line_data* ls, uint32 x);
 
 enum { TVMR_8BPP   = 0x1 };
 enum { TVMR_ROTATE = 0x2 };
@@ -200,7 +201,7 @@ struct VileTex
 //
 //
 template<bool die, unsigned bpp8, bool MSBOn, bool UserClipEn, bool UserClipMode, bool MeshEn, bool HalfFGEn, bool HalfBGEn>
-static INLINE int32 PlotPixel(int32 x, int32 y, uint16 pix, bool transparent, GourauderTheTerrible* g)
+static INLINE int32 PlotPixel(uint16* const fb, const uint8 fbcr, int32 x, int32 y, uint16 pix, bool transparent, GourauderTheTerrible* g)
 {
  static_assert(!MSBOn || (!HalfFGEn && !HalfBGEn), "Table error; sub-optimal template arguments.");
  int32 ret = 0;
@@ -208,12 +209,12 @@ static INLINE int32 PlotPixel(int32 x, int32 y, uint16 pix, bool transparent, Go
 
  if(die)
  {
-  fbyptr = &FB[FBDrawWhich][((y >> 1) & 0xFF) << 9];
-  transparent |= ((y & 1) != (bool)(FBCR & FBCR_DIL));
+  fbyptr = &fb[((y >> 1) & 0xFF) << 9];
+  transparent |= ((y & 1) != (bool)(fbcr & FBCR_DIL));
  }
  else
  {
-  fbyptr = &FB[FBDrawWhich][(y & 0xFF) << 9];
+  fbyptr = &fb[(y & 0xFF) << 9];
  }
 
  if(MeshEn)
@@ -334,23 +335,41 @@ struct line_data
  bool HSS;
  uint16 color;
  int32 ec_count;
- uint32 (MDFN_FASTCALL *tffn)(uint32);
+ uint32 (MDFN_FASTCALL *tffn)(line_data* ls, uint32 x);
  uint16 CLUT[0x10];
  uint32 cb_or;
  uint32 tex_base;
+
+ //
+ // Copies of VDP1 state that the line drawing functions use, refreshed by Update() before each drawing command, so
+ // that a queued line(see DrawThread_QueueLine()) draws the same way no matter when it's drawn.
+ //
+ int32 SysClipX, SysClipY;
+ int32 UserClipX0, UserClipY0, UserClipX1, UserClipY1;
+ uint8 FBCR;
+ uint16* fb;
 };
 
 extern line_data LineSetup;
 
-template<bool AA, bool die, unsigned bpp8, bool MSBOn, bool UserClipEn, bool UserClipMode, bool MeshEn, bool ECD, bool SPD, bool Textured, bool GouraudEn, bool HalfFGEn, bool HalfBGEn>
-static int32 DrawLine(void)
+typedef int32 (*line_fn)(line_data* ls);
+
+//
+// With TimingOnly, nothing is drawn, and only the cycle count is returned; it's the same as what the drawing variant
+// returns for the same line.  Per-pixel cost only depends on MSBOn and HalfBGEn, and a line is only cut short by
+// clipping and end codes, so when neither can happen it's calculated without stepping through the line.
+//
+template<bool AA, bool die, unsigned bpp8, bool MSBOn, bool UserClipEn, bool UserClipMode, bool MeshEn, bool ECD, bool SPD, bool Textured, bool GouraudEn, bool HalfFGEn, bool HalfBGEn, bool TimingOnly = false>
+static int32 DrawLine(line_data* const ls)
 {
- const uint16 color = LineSetup.color;
- line_vertex p0 = LineSetup.p[0];
- line_vertex p1 = LineSetup.p[1];
+ const int32 SysClipX = ls->SysClipX, SysClipY = ls->SysClipY;
+ const int32 UserClipX0 = ls->UserClipX0, UserClipY0 = ls->UserClipY0, UserClipX1 = ls->UserClipX1, UserClipY1 = ls->UserClipY1;
+ const uint16 color = ls->color;
+ line_vertex p0 = ls->p[0];
+ line_vertex p1 = ls->p[1];
  int32 ret = 0;
 
- if(!LineSetup.PCD)
+ if(!ls->PCD)
  {
   // TODO:
   //	Plain clipping treats system clip X as an unsigned 10-bit quantity...
@@ -403,6 +422,26 @@ static int32 DrawLine(void)
 
  ret += 8;
 
+ if(TimingOnly && (!Textured || ECD))
+ {
+  bool inside = ((uint32)p0.x <= (uint32)SysClipX) & ((uint32)p0.y <= (uint32)SysClipY) & ((uint32)p1.x <= (uint32)SysClipX) & ((uint32)p1.y <= (uint32)SysClipY);
+
+  if(UserClipEn && !UserClipMode)
+  {
+   inside &= (std::min<int32>(p0.x, p1.x) >= UserClipX0) & (std::max<int32>(p0.x, p1.x) <= UserClipX1);
+   inside &= (std::min<int32>(p0.y, p1.y) >= UserClipY0) & (std::max<int32>(p0.y, p1.y) <= UserClipY1);
+  }
+
+  if(inside)
+  {
+   const int32 abs_dx = abs(p1.x - p0.x);
+   const int32 abs_dy = abs(p1.y - p0.y);
+   const int32 num_pixels = std::max<int32>(abs_dx, abs_dy) + 1 + (AA ? std::min<int32>(abs_dx, abs_dy) : 0);
+
+   return ret + num_pixels * ((MSBOn || HalfBGEn) ? 6 : 1);
+  }
+ }
+
  //
  //
  const int32 dx = p1.x - p0.x;
@@ -419,29 +458,33 @@ static int32 DrawLine(void)
  GourauderTheTerrible g;
  VileTex t;
 
- if(GouraudEn)
+ uint16* const fb = ls->fb;
+ const uint8 fbcr = ls->FBCR;
+
+ if(GouraudEn && !TimingOnly)
   g.Setup(max_adx_ady + 1, p0.g, p1.g);
 
  if(Textured)
  {
-  LineSetup.ec_count = 2;	// Call before tffn()
+  ls->ec_count = 2;	// Call before tffn()
 
-  if(MDFN_UNLIKELY(max_adx_ady < abs(p1.t - p0.t) && LineSetup.HSS))
+  if(MDFN_UNLIKELY(max_adx_ady < abs(p1.t - p0.t) && ls->HSS))
   {
-   LineSetup.ec_count = 0x7FFFFFFF;
-   t.Setup(max_adx_ady + 1, p0.t >> 1, p1.t >> 1, 2, (bool)(FBCR & FBCR_EOS));
+   ls->ec_count = 0x7FFFFFFF;
+   t.Setup(max_adx_ady + 1, p0.t >> 1, p1.t >> 1, 2, (bool)(ls->FBCR & FBCR_EOS));
   }
   else
    t.Setup(max_adx_ady + 1, p0.t, p1.t);
 
-  texel = LineSetup.tffn(t.Current());
+  if(!TimingOnly || !ECD)
+   texel = ls->tffn(ls, t.Current());
  }
 
  #define PSTART							\
 	bool transparent;					\
 	uint16 pix;						\
 								\
-	if(Textured)						\
+	if(Textured && (!TimingOnly || !ECD))			\
 	{							\
 	 /*ret++;*/							\
 	 while(t.IncPending())					\
@@ -450,9 +493,9 @@ static int32 DrawLine(void)
 								\
 	  /*ret += (bool)t.IncPending();*/				\
 								\
-	  texel = LineSetup.tffn(tx);				\
+	  texel = ls->tffn(ls, tx);				\
 								\
-	  if(!ECD && MDFN_UNLIKELY(LineSetup.ec_count <= 0))	\
+	  if(!ECD && MDFN_UNLIKELY(ls->ec_count <= 0))		\
 	   return ret;						\
 	 }							\
 	 t.AddError();						\
@@ -464,7 +507,9 @@ static int32 DrawLine(void)
 	{			\
 	 pix = color;		\
 	 transparent = !SPD;	\
-	}
+	}			\
+	(void)pix;		\
+	(void)transparent;
 
  /* hmm, possible problem with AA and drawn_ac...*/
  #define PBODY(px, py)											\
@@ -482,12 +527,15 @@ static int32 DrawLine(void)
 	 if(UserClipEn && UserClipMode)									\
 	  clipped |= (px >= UserClipX0) & (px <= UserClipX1) & (py >= UserClipY0) & (py <= UserClipY1);	\
 													\
-	 ret += PlotPixel<die, bpp8, MSBOn, UserClipEn, UserClipMode, MeshEn, HalfFGEn, HalfBGEn>(px, py, pix, transparent | clipped, (GouraudEn ? &g : NULL));	\
+	 if(TimingOnly)											\
+	  ret += (MSBOn || HalfBGEn) ? 6 : 1;								\
+	 else												\
+	  ret += PlotPixel<die, bpp8, MSBOn, UserClipEn, UserClipMode, MeshEn, HalfFGEn, HalfBGEn>(fb, fbcr, px, py, pix, transparent | clipped, (GouraudEn ? &g : NULL));	\
 	}
 
  #define PEND						\
 	{						\
-	 if(GouraudEn)					\
+	 if(GouraudEn && !TimingOnly)			\
 	  g.Step();					\
         }
 
@@ -582,6 +630,27 @@ static int32 DrawLine(void)
  return ret;
 }
 
+//
+// Draw thread(see vdp1.cpp).
+//
+extern bool DrawThreadEnabled;
+void DrawThread_QueueLine(line_fn draw_fn);
+
+//
+// Draws the line in LineSetup with draw_fn, or with the draw thread enabled, queues it to be drawn there and gets the
+// cycle count from timing_fn(the TimingOnly variant of draw_fn) instead.
+//
+static INLINE int32 CallLineFn(const line_fn draw_fn, const line_fn timing_fn)
+{
+ if(DrawThreadEnabled)
+ {
+  DrawThread_QueueLine(draw_fn);
+  return timing_fn(&LineSetup);
+ }
+
+ return draw_fn(&LineSetup);
+}
+
 template<bool gourauden>
 struct EdgeStepper
 {
@@ -25,7 +25,7 @@
 namespace VDP1
 {
 
-static int32 (*LineFuncTab[2][3][0x20][8 + 1])(void) =
+static int32 (*LineFuncTab[2][3][0x20][8 + 1])(line_data* ls) =
 {
  #define LINEFN_BC(die, bpp8, b, c)	\
 	DrawLine<false, die, bpp8, c == 0x8, (bool)(b & 0x10), (b & 0x10) && (b & 0x08), (bool)(b & 0x04), false/*b & 0x02*/, (bool)(b & 0x01), false, (bool)(c & 0x4), (bool)(c & 0x2), (bool)(c & 0x1)>
@@ -67,6 +67,35 @@ static int32 (*LineFuncTab[2][3][0x20][8 + 1])(void) =
  #undef LINEFN_BC
 };
 
+//
+// TimingOnly variants of the above, for when the draw thread is enabled; only the parameters that affect timing vary.
+//
+static int32 (*const LineTimingTab[0x20][8 + 1])(line_data* ls) =
+{
+ #define LINETFN_BC(b, c)	\
+	DrawLine<false, false, 0, c == 0x8, (bool)(b & 0x10), (b & 0x10) && (b & 0x08), false, false, false, false, false, false, (bool)(c & 0x1), true>
+
+ #define LINETFN_B(b)									\
+	{										\
+	 LINETFN_BC(b, 0x0), LINETFN_BC(b, 0x1), LINETFN_BC(b, 0x2), LINETFN_BC(b, 0x3),	\
+	 LINETFN_BC(b, 0x4), LINETFN_BC(b, 0x5), LINETFN_BC(b, 0x6), LINETFN_BC(b, 0x7), 	\
+	 LINETFN_BC(b, 0x8), 	/* msb on */						\
+	}
+
+ LINETFN_B(0x00), LINETFN_B(0x01), LINETFN_B(0x02), LINETFN_B(0x03),
+ LINETFN_B(0x04), LINETFN_B(0x05), LINETFN_B(0x06), LINETFN_B(0x07),
+ LINETFN_B(0x08), LINETFN_B(0x09), LINETFN_B(0x0A), LINETFN_B(0x0B),
+ LINETFN_B(0x0C), LINETFN_B(0x0D), LINETFN_B(0x0E), LINETFN_B(0x0F),
+
+ LINETFN_B(0x10), LINETFN_B(0x11), LINETFN_B(0x12), LINETFN_B(0x13),
+ LINETFN_B(0x14), LINETFN_B(0x15), LINETFN_B(0x16), LINETFN_B(0x17),
+ LINETFN_B(0x18), LINETFN_B(0x19), LINETFN_B(0x1A), LINETFN_B(0x1B),
+ LINETFN_B(0x1C), LINETFN_B(0x1D), LINETFN_B(0x1E), LINETFN_B(0x1F),
+
+ #undef LINETFN_B
+ #undef LINETFN_BC
+};
+
 static INLINE int32 CMD_Line_Polyline_num_lines_4(const uint16* cmd_data)
 {
  const uint16 mode = cmd_data[0x2];
@@ -80,11 +109,12 @@ static INLINE int32 CMD_Line_Polyline_num_lines_4(const uint16* cmd_data)
  LineSetup.PCD = mode & 0x800;
 
  if(((mode >> 3) & 0x7) < 0x6)
-  SPD_Opaque = (int32)(TexFetchTab[(mode >> 3) & 0x1F](0xFFFFFFFF)) >= 0;
+  SPD_Opaque = (int32)(TexFetchTab[(mode >> 3) & 0x1F](&LineSetup, 0xFFFFFFFF)) >= 0;
  //
  //
  //
  auto* fnptr = LineFuncTab[(bool)(FBCR & FBCR_DIE)][(TVMR & TVMR_8BPP) ? ((TVMR & TVMR_ROTATE) ? 2 : 1) : 0][((mode >> 6) & 0x1E) | SPD_Opaque /*(mode >> 6) & 0x1F*/][(mode & 0x8000) ? 8 : (mode & 0x7)];
+ auto* timing_fnptr = LineTimingTab[((mode >> 6) & 0x1E) | SPD_Opaque][(mode & 0x8000) ? 8 : (mode & 0x7)];
 
  CheckUndefClipping();
 
@@ -104,7 +134,7 @@ static INLINE int32 CMD_Line_Polyline_num_lines_4(const uint16* cmd_data)
    LineSetup.p[1].g = gtb[(n + 1) & 0x3];
   }
 
-  ret += fnptr();
+  ret += CallLineFn(fnptr, timing_fnptr);
  }
 
  return ret;
@@ -123,11 +153,12 @@ static INLINE int32 CMD_Line_Polyline_num_lines_1(const uint16* cmd_data)
  LineSetup.PCD = mode & 0x800;
 
  if(((mode >> 3) & 0x7) < 0x6)
-  SPD_Opaque = (int32)(TexFetchTab[(mode >> 3) & 0x1F](0xFFFFFFFF)) >= 0;
+  SPD_Opaque = (int32)(TexFetchTab[(mode >> 3) & 0x1F](&LineSetup, 0xFFFFFFFF)) >= 0;
  //
  //
  //
  auto* fnptr = LineFuncTab[(bool)(FBCR & FBCR_DIE)][(TVMR & TVMR_8BPP) ? ((TVMR & TVMR_ROTATE) ? 2 : 1) : 0][((mode >> 6) & 0x1E) | SPD_Opaque /*(mode >> 6) & 0x1F*/][(mode & 0x8000) ? 8 : (mode & 0x7)];
+ auto* timing_fnptr = LineTimingTab[((mode >> 6) & 0x1E) | SPD_Opaque][(mode & 0x8000) ? 8 : (mode & 0x7)];
 
  CheckUndefClipping();
 
@@ -147,7 +178,7 @@ static INLINE int32 CMD_Line_Polyline_num_lines_1(const uint16* cmd_data)
    LineSetup.p[1].g = gtb[(n + 1) & 0x3];
   }
 
-  ret += fnptr();
+  ret += CallLineFn(fnptr, timing_fnptr);
  }
 
  return ret;
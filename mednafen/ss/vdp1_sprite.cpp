@@ -27,7 +27,7 @@
 namespace VDP1
 {
 
-static int32 (*LineFuncTab[2][3][0x20][8 + 1])(void) =
+static int32 (*LineFuncTab[2][3][0x20][8 + 1])(line_data* ls) =
 {
  #define LINEFN_BC(die, bpp8, b, c)	\
 	DrawLine<true, die, bpp8, c == 0x8, (bool)(b & 0x10), (b & 0x10) && (b & 0x08), (bool)(b & 0x04), (bool)(b & 0x02), (bool)(b & 0x01), true, (bool)(c & 0x4), (!bpp8) && (c & 0x2), (bool)(c & 0x1)>
@@ -69,6 +69,35 @@ static int32 (*LineFuncTab[2][3][0x20][8 + 1])(void) =
  #undef LINEFN_BC
 };
 
+//
+// TimingOnly variants of the above, for when the draw thread is enabled; only the parameters that affect timing vary.
+//
+static int32 (*const LineTimingTab[0x20][8 + 1])(line_data* ls) =
+{
+ #define LINETFN_BC(b, c)	\
+	DrawLine<true, false, 0, c == 0x8, (bool)(b & 0x10), (b & 0x10) && (b & 0x08), false, (bool)(b & 0x02), false, true, false, false, (bool)(c & 0x1), true>
+
+ #define LINETFN_B(b)									\
+	{										\
+	 LINETFN_BC(b, 0x0), LINETFN_BC(b, 0x1), LINETFN_BC(b, 0x2), LINETFN_BC(b, 0x3),	\
+	 LINETFN_BC(b, 0x4), LINETFN_BC(b, 0x5), LINETFN_BC(b, 0x6), LINETFN_BC(b, 0x7), 	\
+	 LINETFN_BC(b, 0x8), 	/* msb on */						\
+	}
+
+ LINETFN_B(0x00), LINETFN_B(0x01), LINETFN_B(0x02), LINETFN_B(0x03),
+ LINETFN_B(0x04), LINETFN_B(0x05), LINETFN_B(0x06), LINETFN_B(0x07),
+ LINETFN_B(0x08), LINETFN_B(0x09), LINETFN_B(0x0A), LINETFN_B(0x0B),
+ LINETFN_B(0x0C), LINETFN_B(0x0D), LINETFN_B(0x0E), LINETFN_B(0x0F),
+
+ LINETFN_B(0x10), LINETFN_B(0x11), LINETFN_B(0x12), LINETFN_B(0x13),
+ LINETFN_B(0x14), LINETFN_B(0x15), LINETFN_B(0x16), LINETFN_B(0x17),
+ LINETFN_B(0x18), LINETFN_B(0x19), LINETFN_B(0x1A), LINETFN_B(0x1B),
+ LINETFN_B(0x1C), LINETFN_B(0x1D), LINETFN_B(0x1E), LINETFN_B(0x1F),
+
+ #undef LINETFN_B
+ #undef LINETFN_BC
+};
+
 /*
  Timing notes:
 	Timing is somewhat complex, and looks like the drawing of the lines of distorted sprites may be terminated
@@ -96,6 +125,7 @@ static INLINE int32 SpriteBase(const uint16* cmd_data)
  line_vertex p[4];
  int32 ret = 0;
  auto* fnptr = LineFuncTab[(bool)(FBCR & FBCR_DIE)][(TVMR & TVMR_8BPP) ? ((TVMR & TVMR_ROTATE) ? 2 : 1) : 0][(mode >> 6) & 0x1F][(mode & 0x8000) ? 8 : (mode & 0x7)];
+ auto* timing_fnptr = LineTimingTab[(mode >> 6) & 0x1F][(mode & 0x8000) ? 8 : (mode & 0x7)];
 
  LineSetup.color = cmd_data[0x3];
  LineSetup.PCD = mode & 0x0800;
@@ -273,7 +303,7 @@ static INLINE int32 SpriteBase(const uint16* cmd_data)
   e[1].GetVertex(&LineSetup.p[1]);
 
   LineSetup.tex_base = tex_base + big_t.PreStep();
-  ret += fnptr();
+  ret += CallLineFn(fnptr, timing_fnptr);
   e[0].Step();
   e[1].Step();
  }
@@ -85,6 +85,7 @@ static struct
 } Window[2];
 
 static uint16 VRAM[262144];
+static uint8 VRAM_Dirty[sizeof(VRAM) >> SS_PAGE_SHIFT];	// For the rewind ring.
 
 static uint16 CRAM[2048];
 
@@ -721,6 +722,7 @@ static INLINE uint32 RW(uint32 A, uint16* DB)
    const unsigned mask = (sizeof(T) == 2) ? 0xFFFF : (0xFF00 >> ((A & 1) << 3));
 
    VRAM[vri] = (VRAM[vri] &~ mask) | (*DB & mask);
+   SS_MarkDirty(VRAM_Dirty, vri << 1);
   }
   else
    *DB = VRAM[vri];
@@ -843,6 +845,7 @@ void Init(const bool IsPAL)
  lastts = 0;
 
  SS_SetPhysMemMap(0x05E00000, 0x05EFFFFF, VRAM, 0x80000, true);
+ MDFNSS_TrackDirty(VRAM, sizeof(VRAM), VRAM_Dirty);
 
  ExLatchIn = false;
 
@@ -1239,6 +1242,7 @@ void PokeVRAM(uint32 addr, const uint8 val)
  addr &= 0x7FFFF;
 
  ne16_wbo_be<uint8>(VRAM, addr, val);
+ SS_MarkDirty(VRAM_Dirty, addr);
  VDP2REND_Write16_DB(addr & ~1, ne16_rbo_be<uint16>(VRAM, addr & ~1));
 }
 
@@ -1247,6 +1251,11 @@ void SetLayerEnableMask(uint64 mask)
  VDP2REND_SetLayerEnableMask(mask);
 }
 
+void SetMixThreads(unsigned count)
+{
+ VDP2REND_SetMixThreads(count);
+}
+
 void StateAction(StateMem* sm, const unsigned load, const bool data_only)
 {
  SFORMAT StateRegs[] =
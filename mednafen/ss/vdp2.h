@@ -38,6 +38,7 @@ void StateAction(StateMem* sm, const unsigned load, const bool data_only) MDFN_C
 
 void Reset(bool powering_up) MDFN_COLD;
 void SetLayerEnableMask(uint64 mask) MDFN_COLD;
+void SetMixThreads(unsigned count) MDFN_COLD;
 
 sscpu_timestamp_t Update(sscpu_timestamp_t timestamp);
 void AdjustTS(const int32 delta);
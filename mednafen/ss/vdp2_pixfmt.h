@@ -0,0 +1,54 @@
+#ifndef __MDFN_SS_VDP2_PIXFMT_H
+#define __MDFN_SS_VDP2_PIXFMT_H
+
+//
+// Layout of the 64-bit pixels the VDP2 renderer's layer line buffers hold, shared with the kernels in vdp2_pix.inc and
+// vdp2_mix.inc, and with the bench/ programs that exercise them.
+//
+
+// Prio(3 bits), color calc(1 bit), layer num(3 bits), 1 bit for palette/rgb format, 1 bit for line color enable, 1 bit for color offs enable, 1 bit for color offs select
+//    1 bit for line color screen enable?, 1 bit allow sprite shadow, 1 bit do sprite shadow
+// Prio, color calc, layer num
+
+enum
+{
+ PIX_ISRGB_SHIFT = 0,	// original format, 0 = paletted, 1 = RGB
+ PIX_LCE_SHIFT = 1,	// Line color enable
+ PIX_COE_SHIFT = 2,	// Color offs enable
+ PIX_COSEL_SHIFT = 3,	// Color offset select(which color offset registers to use)
+ PIX_CCE_SHIFT = 4,	// Color calc enable
+
+ //
+ // Sprite shadow nonsense
+ // Keep these in this order at these bit positions
+ PIX_SHADEN_SHIFT = 5,	//
+ PIX_DOSHAD_SHIFT = 6,
+ PIX_SELFSHAD_SHIFT = 7,
+ PIX_SHADHALVTEST8_VAL = 0x60,
+ //
+ //
+ //
+ //
+
+ // 8 ... 15
+ PIX_PRIO_TEST_SHIFT = 8,
+ PIX_PRIO_SHIFT = PIX_PRIO_TEST_SHIFT + 3,
+
+ //
+ PIX_GRAD_SHIFT = 16,
+ PIX_LAYER_CCE_SHIFT = 17,	// For extended color calculation
+
+ // 24...31
+ PIX_CCRATIO_SHIFT = 24,
+
+ // 32 ... 55
+ PIX_RGB_SHIFT = 32,
+
+ //
+ PIX_SWBIT_SHIFT = 56,
+
+ // Reminder that highest bit can be == 1 when RGB data is pulled from ColorCache
+ //SPECIAL_CCALC_SHIFT = 63
+};
+
+#endif
@@ -27,6 +27,7 @@
 #include "ss.h"
 #include "ss_memory.h"
 #include "vdp2_common.h"
+#include "vdp2_pixfmt.h"
 #include "vdp2_render.h"
 
 #include <retro_timers.h>
@@ -35,6 +36,11 @@
 #include <array>
 #include <atomic>
 #include <algorithm>
+#include <chrono>
+
+#ifdef __SSE2__
+ #include <emmintrin.h>
+#endif
 
 //uint8 vdp2rend_prepad_bss
 
@@ -1160,51 +1166,6 @@ static void Reset(bool powering_up)
    coe = 0;
 }
 
-// Prio(3 bits), color calc(1 bit), layer num(3 bits), 1 bit for palette/rgb format, 1 bit for line color enable, 1 bit for color offs enable, 1 bit for color offs select
-//    1 bit for line color screen enable?, 1 bit allow sprite shadow, 1 bit do sprite shadow
-// Prio, color calc, layer num
-
-enum
-{
- PIX_ISRGB_SHIFT = 0,	// original format, 0 = paletted, 1 = RGB
- PIX_LCE_SHIFT = 1,	// Line color enable
- PIX_COE_SHIFT = 2,	// Color offs enable
- PIX_COSEL_SHIFT = 3,	// Color offset select(which color offset registers to use)
- PIX_CCE_SHIFT = 4,	// Color calc enable
-
- //
- // Sprite shadow nonsense
- // Keep these in this order at these bit positions
- PIX_SHADEN_SHIFT = 5,	//
- PIX_DOSHAD_SHIFT = 6,
- PIX_SELFSHAD_SHIFT = 7,
- PIX_SHADHALVTEST8_VAL = 0x60,
- //
- //
- //
- //
-
- // 8 ... 15
- PIX_PRIO_TEST_SHIFT = 8,
- PIX_PRIO_SHIFT = PIX_PRIO_TEST_SHIFT + 3,
-
- //
- PIX_GRAD_SHIFT = 16,
- PIX_LAYER_CCE_SHIFT = 17,	// For extended color calculation
-
- // 24...31
- PIX_CCRATIO_SHIFT = 24,
-
- // 32 ... 55
- PIX_RGB_SHIFT = 32,
-
- //
- PIX_SWBIT_SHIFT = 56,
-
- // Reminder that highest bit can be == 1 when RGB data is pulled from ColorCache
- //SPECIAL_CCALC_SHIFT = 63
-};
-
 static INLINE void GetCWV(const uint8 ctrl, const bool* const xmet, bool* cwv)
 {
  const bool logic = (ctrl >> 7) & 1;	// 0 = OR, 1 = AND
@@ -1471,77 +1432,7 @@ static INLINE void MakeSFCodeLUT(const unsigned layer, int16* const sfcode_lut)
  }
 }
 
-static INLINE uint32 rgb15_to_rgb24(uint16 src)
-{
- return ((((src << 3) & 0xF8) | ((src << 6) & 0xF800) | ((src << 9) & 0xF80000) | ((src << 16) & 0x80000000)));;
-}
-
-template<bool TA_bmen, unsigned TA_bpp, bool TA_isrgb, bool TA_igntp, unsigned TA_PrioMode, unsigned TA_CCMode, typename T>
-static INLINE uint64 MakeNBGRBGPix(T& tf, const uint32 pix_base_or, const int16* sfcode_lut, const uint32 ix, const uint32 iy)
-{
- uint32 cellx = (ix ^ tf.cellx_xor);
- const uint16* vrb = &tf.tile_vrb[((cellx * TA_bpp) >> 4)];
- //
- //
- //
- uint32 pbor = pix_base_or;
- uint32 rgb24;
- bool opaque;
-
- if(TA_CCMode == 1 || (TA_CCMode == 2 && !TA_isrgb))
-  pbor |= (tf.scc << PIX_CCE_SHIFT);
-
- if(TA_PrioMode == 1 || (TA_PrioMode == 2 && !TA_isrgb))
-  pbor |= (tf.spr << PIX_PRIO_SHIFT);
-
- if(TA_isrgb)
- {
-  if(TA_bpp == 32)
-  {
-   uint32 tmp = (vrb[0] << 16) | vrb[1];
-
-   rgb24 = tmp & 0xFFFFFF;
-   opaque = (bool)(tmp & 0x80000000);
-  }
-  else
-  {
-   uint32 tmp = vrb[0];
-
-   rgb24 = rgb15_to_rgb24(tmp & 0x7FFF);
-   opaque = (bool)(tmp & 0x8000);
-  }
-
-  if(TA_CCMode == 3)
-   pbor |= (1 << PIX_CCE_SHIFT);
- }
- else
- {
-  uint32 dcc;
-  uint32 tmp = vrb[0]; //charno ^ (charno << 8); //vrb[0];
-
-  if(TA_bpp == 16)
-   dcc = tmp & 0x7FF;
-  else if(TA_bpp == 8)
-   dcc = (tmp >> (((cellx & 1) ^ 1) << 3)) & 0xFF;
-  else
-   dcc = (tmp >> (((cellx & 3) ^ 3) << 2)) & 0x0F;
-
-  opaque = (bool)dcc;
-
-  rgb24 = ColorCache[(tf.pcco + dcc) & 2047];
-
-  if(TA_CCMode == 3)
-   pbor |= ((int32)rgb24 >> 31) & (1 << PIX_CCE_SHIFT);
-  //
-  if(TA_PrioMode == 2 || TA_CCMode == 2)
-   pbor &= *(const int16*)((const uint8*)sfcode_lut + (dcc & 0xE));
- }
-
- if(!TA_igntp && !opaque)
-  pbor = 0;
-
- return pbor | ((uint64)rgb24 << PIX_RGB_SHIFT);
-}
+#include "vdp2_pix.inc"
 
 template<bool TA_bmen, unsigned TA_bpp, bool TA_isrgb, bool TA_igntp, unsigned TA_PrioMode, unsigned TA_CCMode>
 static void T_DrawNBG(const unsigned n, uint64* bgbuf, const unsigned w, const uint32 pix_base_or)
@@ -1613,6 +1504,17 @@ static void T_DrawNBG(const unsigned n, uint64* bgbuf, const unsigned w, const u
      iy = LB.vcscr[n][(i + 7) >> 3];
 
     tf.Fetch<TA_bpp>(TA_bmen, ix, iy);
+
+    //
+    // Not zoomed, and at the start of a tile row that's entirely on this line: do all 8 dots at once.
+    //
+    if(NBGRBGPixRowFaster(TA_bpp, TA_isrgb) && xcinc == 0x100 && !(ix & 0x7) && (i + 8) <= w)
+    {
+     MakeNBGRBGPixRow<TA_bpp, TA_isrgb, TA_igntp, TA_PrioMode, TA_CCMode>(tf, pix_base_or, sfcode_lut, &bgbuf[i]);
+     i += 7;
+     xc += 0x800;
+     continue;
+    }
    }
    //
    //
@@ -1641,25 +1543,6 @@ static void (*DrawNBG[2 /*bitmap enable*/][5/*col mode*/][2/*igntp*/][3/*priomod
  }
 };
 
-template<bool TA_igntp, unsigned TA_PrioMode, unsigned TA_CCMode>
-static INLINE uint64 MakeNBG23Pix(uint32 dcc, uint32 pbor, const int16* sfcode_lut, uint32 colcacheoffs)
-{
- uint32 rgb24;
-
- rgb24 = ColorCache[(colcacheoffs + dcc) & 2047];
-
- if(TA_CCMode == 3)
-  pbor |= ((int32)rgb24 >> 31) & (1 << PIX_CCE_SHIFT);
-
- if(TA_PrioMode == 2 || TA_CCMode == 2)
-  pbor &= *(const int16*)((const uint8*)sfcode_lut + (dcc & 0xE));
-
- if(!TA_igntp && !dcc)
-  pbor = 0;
-
- return pbor + ((uint64)rgb24 << PIX_RGB_SHIFT);
-}
-
 //
 // CCMode will be forced to 0 in the effective instantiation if corresponding NBG CCE bit in CCCTL is 0.
 //
@@ -1706,68 +1589,14 @@ static void T_DrawNBG23(const unsigned n, uint64* bgbuf, const unsigned w, const
 
  while(MDFN_LIKELY(tc--))
  {
-  uint32 pbor = pix_base_or;
-
   tf.Fetch<TA_bpp>(false, tx << 3, yscr);
 
-  if(TA_CCMode == 1 || TA_CCMode == 2)
-   pbor |= (tf.scc << PIX_CCE_SHIFT);
-
-  if(TA_PrioMode == 1 || TA_PrioMode == 2)
-   pbor |= (tf.spr << PIX_PRIO_SHIFT);
-  //
-  //
-  auto* const mbp = MakeNBG23Pix<TA_igntp, TA_PrioMode, TA_CCMode>;
-
-  if(TA_bpp == 8)
-  {
-   if(tf.cellx_xor & 0x7)
-   {
-    bgbuf[7] = mbp((uint8)(tf.tile_vrb[0] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[6] = mbp((uint8)(tf.tile_vrb[0] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[5] = mbp((uint8)(tf.tile_vrb[1] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[4] = mbp((uint8)(tf.tile_vrb[1] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[3] = mbp((uint8)(tf.tile_vrb[2] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[2] = mbp((uint8)(tf.tile_vrb[2] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[1] = mbp((uint8)(tf.tile_vrb[3] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[0] = mbp((uint8)(tf.tile_vrb[3] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-   }
-   else
-   {
-    bgbuf[0] = mbp((uint8)(tf.tile_vrb[0] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[1] = mbp((uint8)(tf.tile_vrb[0] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[2] = mbp((uint8)(tf.tile_vrb[1] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[3] = mbp((uint8)(tf.tile_vrb[1] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[4] = mbp((uint8)(tf.tile_vrb[2] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[5] = mbp((uint8)(tf.tile_vrb[2] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[6] = mbp((uint8)(tf.tile_vrb[3] >>  8), /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[7] = mbp((uint8)(tf.tile_vrb[3] >>  0), /**/pbor, sfcode_lut, tf.pcco);
-   }
-  }
+  if(NBGRBGPixRowFaster(TA_bpp, false))
+   MakeNBGRBGPixRow<TA_bpp, false, TA_igntp, TA_PrioMode, TA_CCMode>(tf, pix_base_or, sfcode_lut, bgbuf);
   else
   {
-   if(tf.cellx_xor & 0x7)
-   {
-    bgbuf[7] = mbp((tf.tile_vrb[0] >>  12),       /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[6] = mbp((tf.tile_vrb[0] >>   8) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[5] = mbp((tf.tile_vrb[0] >>   4) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[4] = mbp((tf.tile_vrb[0] >>   0) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[3] = mbp((tf.tile_vrb[1] >>  12),       /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[2] = mbp((tf.tile_vrb[1] >>   8) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[1] = mbp((tf.tile_vrb[1] >>   4) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[0] = mbp((tf.tile_vrb[1] >>   0) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-   }
-   else
-   {
-    bgbuf[0] = mbp((tf.tile_vrb[0] >>  12),       /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[1] = mbp((tf.tile_vrb[0] >>   8) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[2] = mbp((tf.tile_vrb[0] >>   4) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[3] = mbp((tf.tile_vrb[0] >>   0) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[4] = mbp((tf.tile_vrb[1] >>  12),       /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[5] = mbp((tf.tile_vrb[1] >>   8) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[6] = mbp((tf.tile_vrb[1] >>   4) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-    bgbuf[7] = mbp((tf.tile_vrb[1] >>   0) & 0xF, /**/pbor, sfcode_lut, tf.pcco);
-   }
+   for(unsigned k = 0; k < 8; k++)
+    bgbuf[k] = MakeNBGRBGPix<false, TA_bpp, false, TA_igntp, TA_PrioMode, TA_CCMode>(tf, pix_base_or, sfcode_lut, (tx << 3) + k, yscr);
   }
 
   //
@@ -2318,35 +2147,41 @@ enum
  MIXIT_SPECIAL_EXCC_LINE_CRAM12 = 0x5
 };
 
+#include "vdp2_mix.inc"
+
+static MixFinishFunc MixFinish = MixFinish_Scalar;
+static MixFinishFunc MixFinishForced = NULL;
+
+//
+// Everything T_MixIt() reads, so that mixing can be done from a snapshot on a mix worker thread.
+//
+struct MixLineSrc
+{
+ const uint64* spr;
+ const uint64* rbg0;
+ const uint64* nbg[4];	// + 8 already applied
+ const uint8* lc;
+ const uint64* blursrc;
+ const uint32* lclut;
+ const int32 (*coffs)[3];
+ uint32 line_pix_l;
+ uint64 back_pix;
+};
+
 template<bool TA_rbg1en, unsigned TA_Special, bool TA_CCRTMD, bool TA_CCMD>
-static void T_MixIt(uint32* target, const unsigned vdp2_line, const unsigned w, const uint32 back_rgb24, const uint64* blursrc)
+static void T_MixIt(uint32* target, const unsigned w, const MixLineSrc& src)
 {
- const uint32* lclut = &ColorCache[CurLCColor &~ 0x7F];
+ const uint32* lclut = src.lclut;
+ const uint64* blursrc = src.blursrc;
+ const uint32 line_pix_l = src.line_pix_l;
+ const uint64 back_pix = src.back_pix;
  uint32 blurprev[2];
+ alignas(16) uint64 pix_buf[704];
+ alignas(16) uint32 sec_buf[704];
 
  if(TA_Special == MIXIT_SPECIAL_GRAD)
   blurprev[0] = blurprev[1] = *blursrc >> PIX_RGB_SHIFT;
 
- uint32 line_pix_l;
- {
-  line_pix_l = 0U << PIX_ISRGB_SHIFT;
-  line_pix_l |= LineColorCCRatio << PIX_CCRATIO_SHIFT;
-  line_pix_l |= ((CCCTL >> 5) & 1) << PIX_CCE_SHIFT;
-  line_pix_l |= ((CCCTL >> 5) & 1) << PIX_LAYER_CCE_SHIFT;
- }
-
- //
- //
- uint64 back_pix;
- {
-  back_pix = (uint64)back_rgb24 << PIX_RGB_SHIFT;
-  back_pix |= 1U << PIX_ISRGB_SHIFT;
-  back_pix |= ((ColorOffsEn >> 5) & 1) << PIX_COE_SHIFT;
-  back_pix |= ((ColorOffsSel >> 5) & 1) << PIX_COSEL_SHIFT;
-  back_pix |= ((SDCTL >> 5) & 1) << PIX_SHADEN_SHIFT;
-  back_pix |= BackCCRatio << PIX_CCRATIO_SHIFT;
- }
-
  for(uint32 i = 0; MDFN_LIKELY(i < w); i++)
  {
   uint64 pix = back_pix;
@@ -2358,12 +2193,12 @@ static void T_MixIt(uint32* target, const unsigned vdp2_line, const unsigned w,
   //
   uint64 tmp_pix[8] =
   {
-   (TA_rbg1en ? 0 : (LB.nbg[3] + 8)[i]),
-   (TA_rbg1en ? 0 : (LB.nbg[2] + 8)[i]),
-   (TA_rbg1en ? 0 : (LB.nbg[1] + 8)[i]),
-   (LB.nbg[0] + 8)[i],
-   LB.rbg0[i],
-   LB.spr[i],
+   (TA_rbg1en ? 0 : src.nbg[3][i]),
+   (TA_rbg1en ? 0 : src.nbg[2][i]),
+   (TA_rbg1en ? 0 : src.nbg[1][i]),
+   src.nbg[0][i],
+   src.rbg0[i],
+   src.spr[i],
    0/*null pixel*/,
    back_pix
   };
@@ -2405,6 +2240,8 @@ static void T_MixIt(uint32* target, const unsigned vdp2_line, const unsigned w,
   //
   // Color calculation
   //
+  uint32 pix2_rgb = 0;
+
   if(pix & (1U << PIX_CCE_SHIFT))
   {
    uint64 pix2, pix3;
@@ -2430,7 +2267,7 @@ static void T_MixIt(uint32* target, const unsigned vdp2_line, const unsigned w,
     // Line color
     //
     const uint64 pix4 = pix3;
-    const uint32 line_pix_rgb = lclut[LB.lc[i]];
+    const uint32 line_pix_rgb = lclut[src.lc[i]];
     pix3 = pix2;
     pix2 = line_pix_l | ((uint64)line_pix_rgb << PIX_RGB_SHIFT);
 
@@ -2481,64 +2318,24 @@ static void T_MixIt(uint32* target, const unsigned vdp2_line, const unsigned w,
     }
    }
 
-   uint32 fore_rgb = pix >> PIX_RGB_SHIFT;
-   uint32 sec_rgb = pix2 >> PIX_RGB_SHIFT;
-   uint32 new_rgb;
-
-   if(TA_CCMD)	// Ignore ratio, add as-is.
-   {
-    new_rgb =  std::min<unsigned>(0x0000FF, (fore_rgb & 0x0000FF) + (sec_rgb & 0x0000FF));
-    new_rgb |= std::min<unsigned>(0x00FF00, (fore_rgb & 0x00FF00) + (sec_rgb & 0x00FF00));
-    new_rgb |= std::min<unsigned>(0xFF0000, (fore_rgb & 0xFF0000) + (sec_rgb & 0xFF0000));
-   }
-   else
-   {
-    unsigned fore_ratio = ((uint32)(TA_CCRTMD ? pix2 : pix) >> PIX_CCRATIO_SHIFT) ^ 0x1F;
-    unsigned sec_ratio = 0x20 - fore_ratio;
-
-    new_rgb =  ((((fore_rgb & 0x0000FF) * fore_ratio) + ((sec_rgb & 0x0000FF) * sec_ratio)) >> 5);
-    new_rgb |= ((((fore_rgb & 0x00FF00) * fore_ratio) + ((sec_rgb & 0x00FF00) * sec_ratio)) >> 5) & 0x00FF00;
-    new_rgb |= ((((fore_rgb & 0xFF0000) * fore_ratio) + ((sec_rgb & 0xFF0000) * sec_ratio)) >> 5) & 0xFF0000;
-   }
-   pix = ((uint64)new_rgb << 32) | (uint32)pix;
-  }
-
-  //
-  // Color offset
-  //
-  if(pix & (1U << PIX_COE_SHIFT))
-  {
-   const unsigned sel = (pix >> PIX_COSEL_SHIFT) & 1;
-   const uint32 rgb_tmp = pix >> PIX_RGB_SHIFT;
-   int32 rt, gt, bt;
-
-   rt = ColorOffs[sel][0] + (rgb_tmp & 0x000000FF);
-   if(rt < 0) rt = 0;
-   if(rt & 0x00000100) rt = 0x000000FF;
-
-   gt = ColorOffs[sel][1] + (rgb_tmp & 0x0000FF00);
-   if(gt < 0) gt = 0;
-   if(gt & 0x00010000) gt = 0x0000FF00;
-
-   bt = ColorOffs[sel][2] + (rgb_tmp & 0x00FF0000);
-   if(bt < 0) bt = 0;
-   if(bt & 0x01000000) bt = 0x00FF0000;
+   //
+   // MixFinish() does the rest, and takes the ratio from pix.
+   //
+   if(TA_CCRTMD)
+    pix = (pix &~ (0xFFULL << PIX_CCRATIO_SHIFT)) | (pix2 & (0xFFULL << PIX_CCRATIO_SHIFT));
 
-   pix = (uint32)pix | ((uint64)(uint32)(rt | gt | bt) << PIX_RGB_SHIFT);
+   pix2_rgb = pix2 >> PIX_RGB_SHIFT;
   }
 
-  //
-  // Sprite shadow
-  //
-  if((uint8)pix >= PIX_SHADHALVTEST8_VAL)
-   pix = (uint32)pix | ((pix >> 1) & 0x7F7F7F00000000ULL);
-
-  target[i] = pix >> PIX_RGB_SHIFT;
+  pix_buf[i] = pix;
+  sec_buf[i] = pix2_rgb;
  }
+
+ MixFinish(target, w, pix_buf, sec_buf, src.coffs, TA_CCMD);
 }
 
 //template<bool TA_rbg1en, unsigned TA_Special, bool TA_CCRTMD, bool TA_CCMD>
-static void (*MixIt[2][6][2][2])(uint32* target, const unsigned vdp2_line, const unsigned w, const uint32 back_rgb24, const uint64* blursrc) =
+static void (*MixIt[2][6][2][2])(uint32* target, const unsigned w, const MixLineSrc& src) =
 {
  {  {  { T_MixIt<0, 0, 0, 0>, T_MixIt<0, 0, 0, 1>,  },  { T_MixIt<0, 0, 1, 0>, T_MixIt<0, 0, 1, 1>,  },  },  {  { T_MixIt<0, 1, 0, 0>, T_MixIt<0, 1, 0, 1>,  },  { T_MixIt<0, 1, 1, 0>, T_MixIt<0, 1, 1, 1>,  },  },  {  { T_MixIt<0, 2, 0, 0>, T_MixIt<0, 2, 0, 1>,  },  { T_MixIt<0, 2, 1, 0>, T_MixIt<0, 2, 1, 1>,  },  },  {  { T_MixIt<0, 3, 0, 0>, T_MixIt<0, 3, 0, 1>,  },  { T_MixIt<0, 3, 1, 0>, T_MixIt<0, 3, 1, 1>,  },  },  {  { T_MixIt<0, 4, 0, 0>, T_MixIt<0, 4, 0, 1>,  },  { T_MixIt<0, 4, 1, 0>, T_MixIt<0, 4, 1, 1>,  },  },  {  { T_MixIt<0, 5, 0, 0>, T_MixIt<0, 5, 0, 1>,  },  { T_MixIt<0, 5, 1, 0>, T_MixIt<0, 5, 1, 1>,  },  },  },
  {  {  { T_MixIt<1, 0, 0, 0>, T_MixIt<1, 0, 0, 1>,  },  { T_MixIt<1, 0, 1, 0>, T_MixIt<1, 0, 1, 1>,  },  },  {  { T_MixIt<1, 1, 0, 0>, T_MixIt<1, 1, 0, 1>,  },  { T_MixIt<1, 1, 1, 0>, T_MixIt<1, 1, 1, 1>,  },  },  {  { T_MixIt<1, 2, 0, 0>, T_MixIt<1, 2, 0, 1>,  },  { T_MixIt<1, 2, 1, 0>, T_MixIt<1, 2, 1, 1>,  },  },  {  { T_MixIt<1, 3, 0, 0>, T_MixIt<1, 3, 0, 1>,  },  { T_MixIt<1, 3, 1, 0>, T_MixIt<1, 3, 1, 1>,  },  },  {  { T_MixIt<1, 4, 0, 0>, T_MixIt<1, 4, 0, 1>,  },  { T_MixIt<1, 4, 1, 0>, T_MixIt<1, 4, 1, 1>,  },  },  {  { T_MixIt<1, 5, 0, 0>, T_MixIt<1, 5, 0, 1>,  },  { T_MixIt<1, 5, 1, 0>, T_MixIt<1, 5, 1, 1>,  },  },  },
@@ -2622,7 +2419,218 @@ static void ReorderRGB(uint32* target, const unsigned w, const unsigned Rshift,
  }
 }
 
-static NO_INLINE void DrawLine(const uint16 out_line, const uint16 vdp2_line, const bool field)
+//
+// Mix worker pool.
+//
+// Layer drawing in DrawLine() carries a lot of state from one line to the next(line scroll, vertical mosaic, line
+// window and back/line color table addresses, register and VRAM writes queued between lines), so it stays on the
+// render thread, in order.  What's left after that, mixing the layers together(plus RGB reordering and horizontal
+// blending), only depends on the line buffers and a few registers; when enabled, those are copied into a MixJob and
+// the mixing is done on one of MixThreadCount worker threads.  Each line is written only to its own row of the
+// output surface, so the output is the same regardless of the order the workers finish in.
+//
+// DrawCounter is decremented(with DrawCounter_Done()) when a line is completely done, so VDP2REND_EndFrame() waits
+// for the workers too.
+//
+enum : unsigned { MIX_THREADS_MAX = 8 };
+enum : unsigned { MIX_JOB_COUNT = 32 };
+
+struct MixJob
+{
+ MixLineSrc src;
+ void (*mix)(uint32* target, const unsigned w, const MixLineSrc& src);
+ uint32* target;
+ unsigned w;
+ uint8 Rshift, Gshift, Bshift;
+ uint32* hblend_target;	// NULL if horizontal blending is disabled.
+ int32* line_width;
+
+ std::atomic_bool Busy;
+
+ uint64 spr[704];
+ uint64 rbg0[704];
+ uint64 nbg[4][704];
+ uint32 lclut[128];
+ int32 coffs[2][3];
+ alignas(16) uint8 lc[704];
+};
+
+static std::atomic_int_least32_t DrawCounter;
+static ssem_t* FrameDoneSem;
+static std::atomic_bool FrameDoneWaiting;
+
+//
+// When VDP2REND_EndFrame() is blocked on FrameDoneSem(see VDP2REND_WAIT_SPIN_PARK and VDP2REND_WAIT_BLOCK), whoever
+// finishes the last line wakes it up.
+//
+static INLINE void DrawCounter_Done(void)
+{
+ if(DrawCounter.fetch_sub(1, std::memory_order_seq_cst) == 1 && FrameDoneWaiting.load(std::memory_order_seq_cst))
+ {
+  if(FrameDoneWaiting.exchange(false, std::memory_order_seq_cst))
+   ssem_signal(FrameDoneSem);
+ }
+}
+
+static MixJob MixJobs[MIX_JOB_COUNT];
+static unsigned MixJobWritePos;
+static std::atomic_uint_least32_t MixJobReadPos;
+static sthread_t* MixThreads[MIX_THREADS_MAX];
+static unsigned MixThreadCount;
+static ssem_t* MixSem;
+static bool MixExit;
+
+static void MixThreadEntry(void* data)
+{
+ for(;;)
+ {
+  ssem_wait(MixSem);
+
+  if(MixExit)
+   break;
+  //
+  // Each signal of MixSem corresponds to one submitted job, so the job claimed here has been submitted.
+  //
+  MixJob* job = &MixJobs[MixJobReadPos.fetch_add(1, std::memory_order_acq_rel) % MIX_JOB_COUNT];
+
+  job->mix(job->target, job->w, job->src);
+  ReorderRGB(job->target, job->w, job->Rshift, job->Gshift, job->Bshift);
+
+  if(job->hblend_target)
+   *job->line_width = ApplyHBlend(job->hblend_target, *job->line_width);
+
+  job->Busy.store(false, std::memory_order_release);
+  DrawCounter_Done();
+ }
+}
+
+static MDFN_COLD void MixPool_Stop(void)
+{
+ if(!MixThreadCount)
+  return;
+
+ for(unsigned i = 0; i < MIX_JOB_COUNT; i++)
+ {
+  while(MixJobs[i].Busy.load(std::memory_order_acquire))
+   retro_sleep(0);
+ }
+
+ MixExit = true;
+
+ for(unsigned i = 0; i < MixThreadCount; i++)
+  ssem_signal(MixSem);
+
+ for(unsigned i = 0; i < MixThreadCount; i++)
+ {
+  sthread_join(MixThreads[i]);
+  MixThreads[i] = NULL;
+ }
+
+ MixThreadCount = 0;
+ MixExit = false;
+
+ ssem_free(MixSem);
+ MixSem = NULL;
+}
+
+static MDFN_COLD void MixPool_Start(unsigned count)
+{
+ assert(!MixThreadCount);
+
+ count = std::min<unsigned>(MIX_THREADS_MAX, count);
+
+ if(!count)
+  return;
+
+ MixJobWritePos = 0;
+ MixJobReadPos.store(0, std::memory_order_release);
+ MixSem = ssem_new(0);
+
+ for(unsigned i = 0; i < count; i++)
+ {
+  if(!(MixThreads[i] = sthread_create(MixThreadEntry, NULL)))
+   break;
+
+  MixThreadCount++;
+ }
+
+ if(!MixThreadCount)
+ {
+  ssem_free(MixSem);
+  MixSem = NULL;
+ }
+}
+
+//
+// Snapshots everything the mix for the current line needs; the returned job is handed off with MixJob_Submit() once
+// DrawLine() is done with it.
+//
+static MixJob* MixJob_Prepare(void (*mix)(uint32* target, const unsigned w, const MixLineSrc& src), uint32* target, const unsigned w, const MixLineSrc& src, const bool rbg1en)
+{
+ MixJob* job = &MixJobs[MixJobWritePos];
+
+ while(MDFN_UNLIKELY(job->Busy.load(std::memory_order_acquire)))
+  retro_sleep(0);
+
+ job->mix = mix;
+ job->target = target;
+ job->w = w;
+ job->Rshift = espec->surface->format.Rshift;
+ job->Gshift = espec->surface->format.Gshift;
+ job->Bshift = espec->surface->format.Bshift;
+ job->hblend_target = NULL;
+ job->line_width = NULL;
+
+ memcpy(job->spr, src.spr, w * sizeof(uint64));
+ memcpy(job->rbg0, src.rbg0, w * sizeof(uint64));
+ for(unsigned n = 0; n < 4; n++)
+ {
+  if(!rbg1en || !n || src.blursrc == src.nbg[n])
+   memcpy(job->nbg[n], src.nbg[n], w * sizeof(uint64));
+ }
+ memcpy(job->lc, src.lc, w);
+ memcpy(job->lclut, src.lclut, sizeof(job->lclut));
+ memcpy(job->coffs, src.coffs, sizeof(job->coffs));
+
+ job->src = src;
+ job->src.spr = job->spr;
+ job->src.rbg0 = job->rbg0;
+ for(unsigned n = 0; n < 4; n++)
+  job->src.nbg[n] = job->nbg[n];
+ job->src.lc = job->lc;
+ job->src.lclut = job->lclut;
+ job->src.coffs = job->coffs;
+
+ if(src.blursrc == src.rbg0)
+  job->src.blursrc = job->rbg0;
+ else if(src.blursrc == src.spr)
+  job->src.blursrc = job->spr;
+ else
+ {
+  for(unsigned n = 0; n < 4; n++)
+  {
+   if(src.blursrc == src.nbg[n])
+    job->src.blursrc = job->nbg[n];
+  }
+ }
+
+ return job;
+}
+
+static void MixJob_Submit(MixJob* job)
+{
+ job->Busy.store(true, std::memory_order_release);
+ MixJobWritePos = (MixJobWritePos + 1) % MIX_JOB_COUNT;
+ ssem_signal(MixSem);
+}
+
+//
+// Returns true if the rest of the line was handed off to a mix worker, which will decrement DrawCounter itself.
+//
+// With "skip"(a frame that won't be shown, e.g. a speculative run-ahead frame), only the line state that carries over
+// to later lines is updated, and nothing is drawn.
+//
+static NO_INLINE bool DrawLine(const uint16 out_line, const uint16 vdp2_line, const bool field, const bool skip)
 {
  uint32* target;
  const int32 tvdw = ((!CorrectAspect || Clock28M) ? 352 : 330) << ((HRes & 0x2) >> 1);
@@ -2631,6 +2639,7 @@ static NO_INLINE void DrawLine(const uint16 out_line, const uint16 vdp2_line, co
  const int32 tvxo = std::max<int32>(0, (int32)(tvdw - w) >> 1);
  uint32 back_rgb24;
  uint32 border_ncf;
+ MixJob* job = NULL;
 
  target = espec->surface->pixels + out_line * espec->surface->pitchinpix;
  espec->LineWidths[out_line] = tvdw;
@@ -2827,6 +2836,44 @@ static NO_INLINE void DrawLine(const uint16 out_line, const uint16 vdp2_line, co
    std::sort(WinPieces.begin(), WinPieces.end());
   }
 
+  for(unsigned n = 0; n < 4; n++)
+  {
+   if(!MosaicVCount || !(MZCTL & (1U << n)))
+   {
+    if(n < 2)
+    {
+     MosEff_YCoordAccum[n] = YCoordAccum[n];	// Don't + (InterlaceMode == IM_DOUBLE && field)
+    }
+    else
+    {
+     MosEff_NBG23_YCounter[n & 1] = NBG23_YCounter[n & 1] + (InterlaceMode == IM_DOUBLE && field);
+    }
+   }
+  }
+
+  if(SCRCTL & 0x0101)
+   FetchVCScroll(w);	// Call after handling line scroll, and before DrawNBG() stuff
+
+  //
+  // FIXME: Timing
+  //
+  // The layers below only use the MosEff_* copies and the vertical cell scroll values fetched above, so the counters
+  // for the next line can be advanced before drawing this one.
+  //
+  for(unsigned n = 0; n < 2; n++)
+  {
+   YCoordAccum[n] += YCoordInc[n] << (InterlaceMode == IM_DOUBLE);
+   NBG23_YCounter[n & 1] += 1 << (InterlaceMode == IM_DOUBLE);
+  }
+
+  if(MosaicVCount >= ((MZCTL >> 12) & 0xF))
+   MosaicVCount = 0;
+  else
+   MosaicVCount++;
+
+  if(skip)
+   return false;
+
   //
   // Process sprite data before NBG0-3 and RBG0-1, but defer applying the window until after NBG and RBG are handled(so the sprite window
   // bit in the sprite linebuffer data isn't trashed prematurely).
@@ -2925,26 +2972,6 @@ static NO_INLINE void DrawLine(const uint16 out_line, const uint16 vdp2_line, co
    MDFN_FastArraySet(LB.lc, CurLCColor & 0x7F, w);
    MDFN_FastArraySet(LB.rbg0, 0, w);
   }
-  //
-  //
-  //
-  for(unsigned n = 0; n < 4; n++)
-  {
-   if(!MosaicVCount || !(MZCTL & (1U << n)))
-   {
-    if(n < 2)
-    {
-     MosEff_YCoordAccum[n] = YCoordAccum[n];	// Don't + (InterlaceMode == IM_DOUBLE && field)
-    }
-    else
-    {
-     MosEff_NBG23_YCounter[n & 1] = NBG23_YCounter[n & 1] + (InterlaceMode == IM_DOUBLE && field);
-    }
-   }
-  }
-
-  if(SCRCTL & 0x0101)
-   FetchVCScroll(w);	// Call after handling line scroll, and before DrawNBG() stuff
 
   if(!(BGON & 0x20))
   {
@@ -3053,30 +3080,55 @@ static NO_INLINE void DrawLine(const uint16 out_line, const uint16 vdp2_line, co
      special += (CCCTL >> 4) & 0x2;
     }
    }
-   MixIt[rbg1en][special][CCRTMD][CCMD](target + tvxo, vdp2_line, w, back_rgb24, blursrc);
-   ReorderRGB(target + tvxo, w, espec->surface->format.Rshift, espec->surface->format.Gshift, espec->surface->format.Bshift);
-  }
+   MixLineSrc src;
 
-  //
-  //
-  //
-  // FIXME: Timing
-  //
-  for(unsigned n = 0; n < 2; n++)
-  {
-   YCoordAccum[n] += YCoordInc[n] << (InterlaceMode == IM_DOUBLE);
-   NBG23_YCounter[n & 1] += 1 << (InterlaceMode == IM_DOUBLE);
+   src.spr = LB.spr;
+   src.rbg0 = LB.rbg0;
+   for(unsigned n = 0; n < 4; n++)
+    src.nbg[n] = LB.nbg[n] + 8;
+   src.lc = LB.lc;
+   src.blursrc = blursrc;
+   src.lclut = &ColorCache[CurLCColor &~ 0x7F];
+   src.coffs = ColorOffs;
+
+   src.line_pix_l = 0U << PIX_ISRGB_SHIFT;
+   src.line_pix_l |= LineColorCCRatio << PIX_CCRATIO_SHIFT;
+   src.line_pix_l |= ((CCCTL >> 5) & 1) << PIX_CCE_SHIFT;
+   src.line_pix_l |= ((CCCTL >> 5) & 1) << PIX_LAYER_CCE_SHIFT;
+
+   src.back_pix = (uint64)back_rgb24 << PIX_RGB_SHIFT;
+   src.back_pix |= 1U << PIX_ISRGB_SHIFT;
+   src.back_pix |= ((ColorOffsEn >> 5) & 1) << PIX_COE_SHIFT;
+   src.back_pix |= ((ColorOffsSel >> 5) & 1) << PIX_COSEL_SHIFT;
+   src.back_pix |= ((SDCTL >> 5) & 1) << PIX_SHADEN_SHIFT;
+   src.back_pix |= BackCCRatio << PIX_CCRATIO_SHIFT;
+
+   if(MixThreadCount)
+    job = MixJob_Prepare(MixIt[rbg1en][special][CCRTMD][CCMD], target + tvxo, w, src, rbg1en);
+   else
+   {
+    MixIt[rbg1en][special][CCRTMD][CCMD](target + tvxo, w, src);
+    ReorderRGB(target + tvxo, w, espec->surface->format.Rshift, espec->surface->format.Gshift, espec->surface->format.Bshift);
+   }
   }
 
-  if(MosaicVCount >= ((MZCTL >> 12) & 0xF))
-   MosaicVCount = 0;
-  else
-   MosaicVCount++;
  }
 
  //
  //
  //
+ if(job)
+ {
+  if(DoHBlend)
+  {
+   job->hblend_target = espec->surface->pixels + out_line * espec->surface->pitchinpix + espec->DisplayRect.x;
+   job->line_width = &espec->LineWidths[out_line];
+  }
+
+  MixJob_Submit(job);
+  return true;
+ }
+
  if(DoHBlend)
  {
   espec->LineWidths[out_line] = ApplyHBlend(espec->surface->pixels + out_line * espec->surface->pitchinpix + espec->DisplayRect.x, espec->LineWidths[out_line]);
@@ -3084,6 +3136,8 @@ static NO_INLINE void DrawLine(const uint16 out_line, const uint16 vdp2_line, co
   // Kind of late, but meh. ;p
   assert((espec->DisplayRect.x + espec->LineWidths[out_line]) <= 704);
  }
+
+ return false;
 }
 
 //
@@ -3094,13 +3148,18 @@ static sthread_t *RThread = NULL;
 enum
 {
  COMMAND_WRITE8 = 0,
- COMMAND_WRITE16,
+ COMMAND_WRITE16_RUN,
 
  COMMAND_DRAW_LINE,
 
  COMMAND_SET_LEM,
 
  COMMAND_SET_BUSYWAIT,
+ COMMAND_SET_WAITMODE,
+
+ COMMAND_SET_MIXTHREADS,
+
+ COMMAND_SET_PROFILE,
 
  COMMAND_RESET,
  COMMAND_EXIT
@@ -3113,18 +3172,102 @@ struct WQ_Entry
  uint32 Arg32;
 };
 
-static std::array<WQ_Entry, 0x80000> WQ;
+static std::array<WQ_Entry, 0x10000> WQ;
 static size_t WQ_ReadPos, WQ_WritePos;
 static std::atomic_int_least32_t WQ_InCount;
-static std::atomic_int_least32_t DrawCounter;
+
+//
+// Runs of 16-bit writes to consecutive addresses(e.g. SCU DMA into VRAM or CRAM) are queued as a single
+// COMMAND_WRITE16_RUN, with the data in WQ_Data.  The run being built isn't visible to the render thread until it's
+// queued by WQ_FlushRun(), which WWQ() does before queueing anything else, so write order is preserved.
+//
+// WQ_DataWritten and WQ_DataRead are free-running counts of 16-bit units, used to find free space in WQ_Data.
+//
+enum : uint32 { WQ_DATA_SIZE = 0x20000 };
+enum : uint32 { WQ_RUN_MAX = 0x1000 };
+
+static std::array<uint16, WQ_DATA_SIZE> WQ_Data;
+static uint32 WQ_DataWritten;
+static std::atomic_uint_least32_t WQ_DataRead;
+static uint32 WQ_RunAddr;
+static uint32 WQ_RunLength;
 static bool DoBusyWait;
 ssem_t* WakeupSem;
 static bool DoWakeupIfNecessary;
 
-static INLINE void WWQ(uint16 command, uint32 arg32 = 0, uint16 arg16 = 0)
+//
+// How the render thread waits for work, and VDP2REND_EndFrame() for the render thread:
+//
+//  VDP2REND_WAIT_BUSY: The render thread is woken up in batches of lines, and busy-waits from line VisibleLines - 48
+//   until the end of the frame; VDP2REND_EndFrame() polls DrawCounter, sleeping 1ms at a time.  Lowest latency, but
+//   keeps a host core busy for a good part of each frame.
+//
+//  VDP2REND_WAIT_SPIN_PARK: Both sides spin for up to WAIT_SPIN_NS, then block on a semaphore until the other side
+//   wakes them up.
+//
+//  VDP2REND_WAIT_BLOCK: Both sides block right away.
+//
+// A side about to block sets its "parked" flag and then checks for work/completion once more, while the other side
+// makes the work/completion visible and then checks the flag, all seq_cst, so a wakeup can't be missed.  Whichever
+// side clears a set flag does the matching ssem_wait()/ssem_signal(), which keeps the semaphores balanced.
+//
+// The render thread is only woken up for lines, not for register and memory writes; those aren't needed until the
+// next line is drawn.
+//
+enum : uint64 { WAIT_SPIN_NS = 50000 };
+
+static unsigned WaitMode;	// Emulation thread's copy.
+static unsigned RT_WaitMode;	// Render thread's copy.
+static std::atomic_bool RThreadParked;
+
+//
+// The wait statistics are only gathered while SS_ProfileActive is set, to keep the clock reads out of normal runs.
+//
+static bool WS_Profile;		// Emulation thread's copy of SS_ProfileActive.
+static bool RT_Profile;		// Render thread's copy.
+static std::atomic_uint_least64_t WS_SpinNS, WS_ParkNS, WS_Parks, WS_DrawNS;	// Written by the render thread.
+static uint64 WS_FrameWaitNS, WS_DepthSum, WS_DepthSamples;		// Written by the emulation thread.
+static uint32 WS_DepthMax;
+
+static INLINE uint64 WaitClockNS(void)
+{
+ return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static INLINE void CPURelax(void)
+{
+#if defined(_MSC_VER)
+ __nop();
+#elif defined(__i386__) || defined(__x86_64__)
+ asm volatile("pause");
+#elif defined(__aarch64__)
+ asm volatile("yield");
+#else
+ std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+static INLINE void WakeRThreadIfParked(void)
+{
+ if(RThreadParked.load(std::memory_order_seq_cst) && RThreadParked.exchange(false, std::memory_order_seq_cst))
+  ssem_signal(WakeupSem);
+}
+
+static NO_INLINE void WQ_WaitForSpace(const uint32 data_needed)
+{
+ if(WaitMode == VDP2REND_WAIT_BUSY)
+  ssem_signal(WakeupSem);
+ else
+  WakeRThreadIfParked();
+
+ while(WQ_InCount.load(std::memory_order_acquire) == WQ.size() || (WQ_DataWritten - WQ_DataRead.load(std::memory_order_acquire)) > (WQ_DATA_SIZE - data_needed))
+  retro_sleep(0);
+}
+
+static INLINE void WQ_Put(uint16 command, uint32 arg32, uint16 arg16)
 {
- while(MDFN_UNLIKELY(WQ_InCount.load(std::memory_order_acquire) == WQ.size()))
-  retro_sleep(1);
+ if(MDFN_UNLIKELY(WQ_InCount.load(std::memory_order_acquire) == WQ.size()))
+  WQ_WaitForSpace(0);
 
  WQ_Entry* wqe = &WQ[WQ_WritePos];
 
@@ -3133,19 +3276,67 @@ static INLINE void WWQ(uint16 command, uint32 arg32 = 0, uint16 arg16 = 0)
  wqe->Arg32 = arg32;
 
  WQ_WritePos = (WQ_WritePos + 1) % WQ.size();
- WQ_InCount.fetch_add(1, std::memory_order_release);
+ WQ_InCount.fetch_add(1, std::memory_order_seq_cst);	// seq_cst for RThreadParked handling.
 }
 
-static void RThreadEntry(void* data)
+static INLINE void WQ_FlushRun(void)
 {
- bool Running = true;
+ if(WQ_RunLength)
+ {
+  WQ_DataWritten += WQ_RunLength;
+  WQ_Put(COMMAND_WRITE16_RUN, WQ_RunAddr, WQ_RunLength);
+  WQ_RunLength = 0;
+ }
+}
 
- while(MDFN_LIKELY(Running))
+static INLINE void WWQ(uint16 command, uint32 arg32 = 0, uint16 arg16 = 0)
+{
+ WQ_FlushRun();
+ WQ_Put(command, arg32, arg16);
+}
+
+static INLINE void WWQ_Write16(uint32 A, uint16 DB)
+{
+ if(WQ_RunLength && A == (WQ_RunAddr + (WQ_RunLength << 1)) && WQ_RunLength < WQ_RUN_MAX)
  {
-  while(MDFN_UNLIKELY(WQ_InCount.load(std::memory_order_acquire) == 0))
+  WQ_Data[(WQ_DataWritten + WQ_RunLength) & (WQ_DATA_SIZE - 1)] = DB;
+  WQ_RunLength++;
+  return;
+ }
+
+ WQ_FlushRun();
+
+ if(MDFN_UNLIKELY((WQ_DataWritten - WQ_DataRead.load(std::memory_order_acquire)) > (WQ_DATA_SIZE - WQ_RUN_MAX)))
+  WQ_WaitForSpace(WQ_RUN_MAX);
+
+ WQ_Data[WQ_DataWritten & (WQ_DATA_SIZE - 1)] = DB;
+ WQ_RunAddr = A;
+ WQ_RunLength = 1;
+}
+
+static NO_INLINE void RThread_WaitForWork(void)
+{
+ const bool profile = RT_Profile;
+ const uint64 start_time = (profile || RT_WaitMode == VDP2REND_WAIT_SPIN_PARK) ? WaitClockNS() : 0;
+ uint64 park_time = 0;
+
+ if(RT_WaitMode == VDP2REND_WAIT_BUSY)
+ {
+  while(WQ_InCount.load(std::memory_order_acquire) == 0)
   {
    if(!DoBusyWait)
-    ssem_wait(WakeupSem);
+   {
+    if(profile)
+    {
+     const uint64 park_start_time = WaitClockNS();
+
+     ssem_wait(WakeupSem);
+     park_time += WaitClockNS() - park_start_time;
+     WS_Parks.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+     ssem_wait(WakeupSem);
+   }
    else
    {
 #ifdef MDFN_SS_BUSYWAIT_PAUSE
@@ -3162,6 +3353,56 @@ static void RThreadEntry(void* data)
 #endif
    }
   }
+ }
+ else
+ {
+  if(RT_WaitMode == VDP2REND_WAIT_SPIN_PARK)
+  {
+   unsigned i = 0;
+
+   while(WQ_InCount.load(std::memory_order_acquire) == 0)
+   {
+    CPURelax();
+
+    if(!(++i & 0x3F) && (WaitClockNS() - start_time) >= WAIT_SPIN_NS)
+     break;
+   }
+  }
+
+  while(WQ_InCount.load(std::memory_order_acquire) == 0)
+  {
+   const uint64 park_start_time = profile ? WaitClockNS() : 0;
+
+   RThreadParked.store(true, std::memory_order_seq_cst);
+
+   if(WQ_InCount.load(std::memory_order_seq_cst) == 0 || !RThreadParked.exchange(false, std::memory_order_seq_cst))
+    ssem_wait(WakeupSem);
+
+   RThreadParked.store(false, std::memory_order_relaxed);
+
+   if(profile)
+   {
+    park_time += WaitClockNS() - park_start_time;
+    WS_Parks.fetch_add(1, std::memory_order_relaxed);
+   }
+  }
+ }
+
+ if(profile)
+ {
+  WS_SpinNS.fetch_add(WaitClockNS() - start_time - park_time, std::memory_order_relaxed);
+  WS_ParkNS.fetch_add(park_time, std::memory_order_relaxed);
+ }
+}
+
+static void RThreadEntry(void* data)
+{
+ bool Running = true;
+
+ while(MDFN_LIKELY(Running))
+ {
+  if(MDFN_UNLIKELY(WQ_InCount.load(std::memory_order_acquire) == 0))
+   RThread_WaitForWork();
   //
   //
   //
@@ -3173,15 +3414,30 @@ static void RThreadEntry(void* data)
 	MemW<uint8>(wqe->Arg32, wqe->Arg16);
 	break;
 
-   case COMMAND_WRITE16:
-	MemW<uint16>(wqe->Arg32, wqe->Arg16);
+   case COMMAND_WRITE16_RUN:
+	{
+	 const uint32 A = wqe->Arg32;
+	 const uint32 count = wqe->Arg16;
+	 const uint32 rd = WQ_DataRead.load(std::memory_order_relaxed);
+
+	 for(uint32 i = 0; i < count; i++)
+	  MemW<uint16>(A + (i << 1), WQ_Data[(rd + i) & (WQ_DATA_SIZE - 1)]);
+
+	 WQ_DataRead.store(rd + count, std::memory_order_release);
+	}
 	break;
 
    case COMMAND_DRAW_LINE:
-	//for(unsigned i = 0; i < 2; i++)
-	DrawLine((uint16)wqe->Arg32, wqe->Arg32 >> 16, wqe->Arg16);
-	//
-	DrawCounter.fetch_sub(1, std::memory_order_release);
+	{
+	 const uint64 start_time = MDFN_UNLIKELY(RT_Profile) ? WaitClockNS() : 0;
+
+	 //for(unsigned i = 0; i < 2; i++)
+	 if(!DrawLine((uint16)wqe->Arg32, wqe->Arg32 >> 16, wqe->Arg16 & 1, (wqe->Arg16 >> 1) & 1))
+	  DrawCounter_Done();
+
+	 if(MDFN_UNLIKELY(RT_Profile))
+	  WS_DrawNS.fetch_add(WaitClockNS() - start_time, std::memory_order_relaxed);
+	}
 	break;
 
    case COMMAND_RESET:
@@ -3196,6 +3452,19 @@ static void RThreadEntry(void* data)
 	DoBusyWait = wqe->Arg32;
 	break;
 
+   case COMMAND_SET_WAITMODE:
+	RT_WaitMode = wqe->Arg32;
+	break;
+
+   case COMMAND_SET_MIXTHREADS:
+	MixPool_Stop();
+	MixPool_Start(wqe->Arg32);
+	break;
+
+   case COMMAND_SET_PROFILE:
+	RT_Profile = wqe->Arg32;
+	break;
+
    case COMMAND_EXIT:
 	Running = false;
 	break;
@@ -3206,6 +3475,8 @@ static void RThreadEntry(void* data)
   WQ_ReadPos = (WQ_ReadPos + 1) % WQ.size();
   WQ_InCount.fetch_sub(1, std::memory_order_release);
  }
+
+ MixPool_Stop();
 }
 
 //
@@ -3219,13 +3490,26 @@ void VDP2REND_Init(const bool IsPAL)
  VisibleLines = PAL ? 288 : 240;
  //
  UserLayerEnableMask = ~0U;
+ MixFinish = MixFinishForced ? MixFinishForced : MixFinish_Select();
 
  //
  WQ_ReadPos = 0;
  WQ_WritePos = 0;
  WQ_InCount.store(0, std::memory_order_release); 
+ WQ_DataWritten = 0;
+ WQ_DataRead.store(0, std::memory_order_release);
+ WQ_RunLength = 0;
  DrawCounter.store(0, std::memory_order_release);
  WakeupSem = ssem_new(0);
+ FrameDoneSem = ssem_new(0);
+ WaitMode = RT_WaitMode = VDP2REND_WAIT_BUSY;
+ WS_Profile = RT_Profile = false;
+ WS_SpinNS.store(0, std::memory_order_relaxed);
+ WS_ParkNS.store(0, std::memory_order_relaxed);
+ WS_Parks.store(0, std::memory_order_relaxed);
+ WS_DrawNS.store(0, std::memory_order_relaxed);
+ WS_FrameWaitNS = WS_DepthSum = WS_DepthSamples = 0;
+ WS_DepthMax = 0;
  RThread = sthread_create(RThreadEntry, NULL);
 }
 
@@ -3297,7 +3581,9 @@ void VDP2REND_Kill(void)
  if(RThread != NULL)
  {
   WWQ(COMMAND_EXIT);
+  ssem_signal(WakeupSem);
   sthread_join(RThread);
+  RThread = NULL;
  }
 
  if(WakeupSem != NULL)
@@ -3305,10 +3591,22 @@ void VDP2REND_Kill(void)
   ssem_free(WakeupSem);
   WakeupSem = NULL;
  }
+
+ if(FrameDoneSem != NULL)
+ {
+  ssem_free(FrameDoneSem);
+  FrameDoneSem = NULL;
+ }
 }
 
 void VDP2REND_StartFrame(EmulateSpecStruct* espec_arg, const bool clock28m, const int SurfInterlaceField)
 {
+ if(MDFN_UNLIKELY(SS_ProfileActive != WS_Profile))
+ {
+  WS_Profile = SS_ProfileActive;
+  WWQ(COMMAND_SET_PROFILE, WS_Profile);
+ }
+
  NextOutLine = 0;
  Clock28M = clock28m;
 
@@ -3331,15 +3629,47 @@ void VDP2REND_StartFrame(EmulateSpecStruct* espec_arg, const bool clock28m, cons
 
 void VDP2REND_EndFrame(void)
 {
- while(MDFN_UNLIKELY(DrawCounter.load(std::memory_order_acquire) != 0))
+ if(DrawCounter.load(std::memory_order_acquire) != 0)
  {
-   ssem_signal(WakeupSem);
-   retro_sleep(1);
+  const uint64 start_time = (WS_Profile || WaitMode == VDP2REND_WAIT_SPIN_PARK) ? WaitClockNS() : 0;
+
+  if(WaitMode == VDP2REND_WAIT_BUSY)
+  {
+   while(MDFN_UNLIKELY(DrawCounter.load(std::memory_order_acquire) != 0))
+   {
+     ssem_signal(WakeupSem);
+     retro_sleep(1);
+   }
+  }
+  else
+  {
+   if(WaitMode == VDP2REND_WAIT_SPIN_PARK)
+   {
+    unsigned i = 0;
+
+    while(DrawCounter.load(std::memory_order_acquire) != 0)
+    {
+     CPURelax();
+
+     if(!(++i & 0x3F) && (WaitClockNS() - start_time) >= WAIT_SPIN_NS)
+      break;
+    }
+   }
+
+   FrameDoneWaiting.store(true, std::memory_order_seq_cst);
+
+   if(DrawCounter.load(std::memory_order_seq_cst) != 0 || !FrameDoneWaiting.exchange(false, std::memory_order_seq_cst))
+    ssem_wait(FrameDoneSem);
+  }
+
+  if(WS_Profile)
+   WS_FrameWaitNS += WaitClockNS() - start_time;
  }
 
- WWQ(COMMAND_SET_BUSYWAIT, false);
+ if(WaitMode == VDP2REND_WAIT_BUSY)
+  WWQ(COMMAND_SET_BUSYWAIT, false);
 
- if(NextOutLine < VisibleLines)
+ if(NextOutLine < VisibleLines && !espec->skip)
  {
   do
   {
@@ -3377,10 +3707,21 @@ void VDP2REND_DrawLine(const int vdp2_line, const uint32 crt_line, const bool fi
    out_line = (out_line << 1) | espec->InterlaceField;
 
   auto wdcq = DrawCounter.fetch_add(1, std::memory_order_release);
-  WWQ(COMMAND_DRAW_LINE, ((uint16)vdp2_line << 16) | out_line, field);
+  WWQ(COMMAND_DRAW_LINE, ((uint16)vdp2_line << 16) | out_line, field | ((bool)espec->skip << 1));
   //
   //
-  if(crt_line == bwthresh)
+  if(MDFN_UNLIKELY(WS_Profile))
+  {
+   const uint32 depth = WQ_InCount.load(std::memory_order_relaxed);
+
+   WS_DepthSum += depth;
+   WS_DepthSamples++;
+   WS_DepthMax = std::max<uint32>(WS_DepthMax, depth);
+  }
+
+  if(WaitMode != VDP2REND_WAIT_BUSY)
+   WakeRThreadIfParked();
+  else if(crt_line == bwthresh)
   {
    WWQ(COMMAND_SET_BUSYWAIT, true);
    ssem_signal(WakeupSem);
@@ -3410,6 +3751,39 @@ void VDP2REND_SetLayerEnableMask(uint64 mask)
  WWQ(COMMAND_SET_LEM, mask);
 }
 
+void VDP2REND_SetMixThreads(unsigned count)
+{
+ WWQ(COMMAND_SET_MIXTHREADS, count);
+}
+
+void VDP2REND_SetWaitMode(unsigned mode)
+{
+ assert(mode <= VDP2REND_WAIT_BLOCK);
+
+ WaitMode = mode;
+ WWQ(COMMAND_SET_WAITMODE, mode);
+ ssem_signal(WakeupSem);
+}
+
+bool VDP2REND_ForceMixKernel(const char* name)
+{
+ MixFinishForced = name ? MixFinish_Get(name) : NULL;
+
+ return !name || MixFinishForced;
+}
+
+void VDP2REND_GetWaitStats(VDP2Rend_WaitStats* stats)
+{
+ stats->spin_ns = WS_SpinNS.load(std::memory_order_relaxed);
+ stats->park_ns = WS_ParkNS.load(std::memory_order_relaxed);
+ stats->parks = WS_Parks.load(std::memory_order_relaxed);
+ stats->frame_wait_ns = WS_FrameWaitNS;
+ stats->draw_ns = WS_DrawNS.load(std::memory_order_relaxed);
+ stats->depth_sum = WS_DepthSum;
+ stats->depth_samples = WS_DepthSamples;
+ stats->depth_max = WS_DepthMax;
+}
+
 void VDP2REND_Write8_DB(uint32 A, uint16 DB)
 {
  //if(DrawCounter.load(std::memory_order_acquire) != 0)
@@ -3421,17 +3795,29 @@ void VDP2REND_Write8_DB(uint32 A, uint16 DB)
 void VDP2REND_Write16_DB(uint32 A, uint16 DB)
 {
  //if(DrawCounter.load(std::memory_order_acquire) != 0)
-  WWQ(COMMAND_WRITE16, A, DB);
+  WWQ_Write16(A, DB);
  //else
  // MemW<uint16>(A, DB);
 }
 
 void VDP2REND_StateAction(StateMem* sm, const unsigned load, const bool data_only, uint16 (&rr)[0x100], uint16 (&cr)[2048], uint16 (&vr)[262144])
 {
- while(MDFN_UNLIKELY(WQ_InCount.load(std::memory_order_acquire) != 0))
+ //
+ // Wait for the render thread to get through the queue.  By the time states are saved or loaded(between frames), that's
+ // usually no more than a few writes queued after the last line, so yield rather than sleeping a whole millisecond at a
+ // time; with run-ahead, this happens twice a frame.
+ //
+ WQ_FlushRun();
+
+ if(MDFN_UNLIKELY(WQ_InCount.load(std::memory_order_acquire) != 0))
  {
-  ssem_signal(WakeupSem);
-  retro_sleep(1);
+  if(WaitMode == VDP2REND_WAIT_BUSY)
+   ssem_signal(WakeupSem);
+  else
+   WakeRThreadIfParked();
+
+  while(WQ_InCount.load(std::memory_order_acquire) != 0)
+   retro_sleep(0);
  }
  //
  //
@@ -32,6 +32,35 @@ void VDP2REND_StartFrame(EmulateSpecStruct* espec, const bool clock28m, const in
 void VDP2REND_EndFrame(void);
 void VDP2REND_Reset(bool powering_up) MDFN_COLD;
 void VDP2REND_SetLayerEnableMask(uint64 mask) MDFN_COLD;
+void VDP2REND_SetMixThreads(unsigned count) MDFN_COLD;
+
+enum
+{
+ VDP2REND_WAIT_BUSY = 0,
+ VDP2REND_WAIT_SPIN_PARK,
+ VDP2REND_WAIT_BLOCK
+};
+void VDP2REND_SetWaitMode(unsigned mode) MDFN_COLD;
+
+// Makes VDP2REND_Init() use the named color calculation/offset/shadow kernel("scalar", "sse2" or "avx2") rather than
+// the fastest one, so that their output can be compared on real content(see bench/core_bench.cpp); NULL undoes it.
+// Returns false if the kernel isn't available on this host.
+bool VDP2REND_ForceMixKernel(const char* name) MDFN_COLD;
+
+// Cumulative since VDP2REND_Init(), counting only frames started while SS_ProfileActive was set.
+struct VDP2Rend_WaitStats
+{
+ uint64 spin_ns;	// Render thread time spent spinning while waiting for work.
+ uint64 park_ns;	// Render thread time spent blocked while waiting for work.
+ uint64 parks;		// Number of times the render thread blocked.
+ uint64 frame_wait_ns;	// Emulation thread time spent in VDP2REND_EndFrame() waiting for the render thread.
+ uint64 draw_ns;	// Render thread time spent drawing lines(not counting mix threads).
+
+ uint64 depth_sum;	// Work queue depth, sampled each time a line is queued.
+ uint64 depth_samples;
+ uint32 depth_max;
+};
+void VDP2REND_GetWaitStats(VDP2Rend_WaitStats* stats);
 
 void VDP2REND_StateAction(StateMem* sm, const unsigned load, const bool data_only, uint16 (&rr)[0x100], uint16 (&cr)[2048], uint16 (&vr)[262144]) MDFN_COLD;
 
@@ -26,6 +26,9 @@
 #include "general.h"
 #include "mednafen-endian.h"
 #include "state.h"
+#include "state_rewind.h"
+
+#include <zlib.h>
 
 #define SSEEK_END	2
 #define SSEEK_CUR	1
@@ -33,6 +36,11 @@
 
 #define RLSB 		MDFNSTATE_RLSB	//0x80000000
 
+static INLINE bool IsPaged(const SFORMAT *sf)
+{
+   return sf->type && sf->size >= SS_PAGE_SIZE;
+}
+
 static int32_t smem_read(StateMem *st, void *buffer, uint32_t len)
 {
    if ((len + st->loc) > st->len)
@@ -46,8 +54,24 @@ static int32_t smem_read(StateMem *st, void *buffer, uint32_t len)
 
 static int32_t smem_write(StateMem *st, void *buffer, uint32_t len)
 {
+   if (st->sizing)
+   {
+      st->loc += len;
+
+      if (st->loc > st->len)
+         st->len = st->loc;
+
+      return(len);
+   }
+
    if ((len + st->loc) > st->malloced)
    {
+      if (st->fixed)
+      {
+         st->overflow = true;
+         return(0);
+      }
+
       uint32_t newsize = (st->malloced >= 32768) ? st->malloced : (st->initial_malloc ? st->initial_malloc : 32768);
 
       while(newsize < (len + st->loc))
@@ -104,7 +128,7 @@ static int smem_read32le(StateMem *st, uint32_t *b)
    return(4);
 }
 
-static void SubWrite(StateMem *st, const SFORMAT *sf)
+static void SubWrite(StateMem *st, const SFORMAT *sf, bool named)
 {
    while(sf->size || sf->name)	// Size can sometimes be zero, so also check for the text name.  These two should both be zero only at the end of a struct.
    {
@@ -118,7 +142,15 @@ static void SubWrite(StateMem *st, const SFORMAT *sf)
 
       if(sf->size == ~0U)		/* Link to another struct.	*/
       {
-         SubWrite(st, (const SFORMAT *)sf->data);
+         SubWrite(st, (const SFORMAT *)sf->data, named);
+
+         sf++;
+         continue;
+      }
+
+      if(st->delta && IsPaged(sf))
+      {
+         MDFNSR_SavePaged(sf);
 
          sf++;
          continue;
@@ -128,13 +160,25 @@ static void SubWrite(StateMem *st, const SFORMAT *sf)
       uintptr_t p            = (uintptr_t)sf->data;
       uint32 repcount        = sf->repcount;
       const size_t repstride = sf->repstride;
-      const int slen         = strlen(sf->name);
 
-      memcpy(&nameo[1], sf->name, slen);
-      nameo[0] = slen;
+      if(named)
+      {
+         const int slen      = strlen(sf->name);
 
-      smem_write(st, nameo, 1 + nameo[0]);
-      smem_write32le(st, bytesize * (repcount + 1));
+         memcpy(&nameo[1], sf->name, slen);
+         nameo[0] = slen;
+
+         smem_write(st, nameo, 1 + nameo[0]);
+         smem_write32le(st, bytesize * (repcount + 1));
+      }
+
+      if(st->sizing)
+      {
+         smem_write(st, NULL, bytesize * (repcount + 1));
+
+         sf++;
+         continue;
+      }
 
 	do
 	{
@@ -294,7 +338,7 @@ static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
 
 	data_start_pos = st->loc;
 
-	SubWrite(st, sf);
+	SubWrite(st, sf, true);
 
 	end_pos = st->loc;
 
@@ -305,11 +349,150 @@ static int WriteStateChunk(StateMem *st, const char *sname, SFORMAT *sf)
 	return(end_pos - data_start_pos);
 }
 
+//
+// Fast layout: each section is just its variables' data, back to back in SFORMAT order, after the size of that data
+// and a hash of the names and sizes of the variables(so that a state from a different configuration, e.g. with a
+// different controller connected, is refused instead of misread).  Sections are found by position, so they must be
+// loaded in the order they were saved.
+//
+static uint32_t LayoutHash(const SFORMAT *sf, uint32_t h)
+{
+   while(sf->size || sf->name)
+   {
+      if(!sf->size || !sf->data)
+      {
+         sf++;
+         continue;
+      }
+
+      if(sf->size == ~0U)		/* Link to another struct.	*/
+         h = LayoutHash((const SFORMAT *)sf->data, h);
+      else
+      {
+         for(const char *n = sf->name; *n; n++)
+            h = (h ^ (uint8_t)*n) * 16777619;
+
+         h = (h ^ sf->size) * 16777619;
+         h = (h ^ sf->repcount) * 16777619;
+      }
+
+      sf++;
+   }
+
+   return h;
+}
+
+static void SubReadFast(StateMem *st, const SFORMAT *sf)
+{
+   while(sf->size || sf->name)
+   {
+      if(!sf->size || !sf->data)
+      {
+         sf++;
+         continue;
+      }
+
+      if(sf->size == ~0U)		/* Link to another struct.	*/
+      {
+         SubReadFast(st, (const SFORMAT *)sf->data);
+
+         sf++;
+         continue;
+      }
+
+      if(st->delta && IsPaged(sf))
+      {
+         MDFNSR_LoadPaged(sf);
+
+         sf++;
+         continue;
+      }
+
+      const auto type        = sf->type;
+      const uint32 size      = sf->size;
+      uintptr_t p            = (uintptr_t)sf->data;
+      uint32 repcount        = sf->repcount;
+      const size_t repstride = sf->repstride;
+
+      do
+      {
+         smem_read(st, (void*)p, size);
+
+         if(!type)
+         {
+            // Converting downwards is necessary for the case of sizeof(bool) > 1
+            for(int32 bool_monster = size - 1; bool_monster >= 0; bool_monster--)
+               ((bool *)p)[bool_monster] = ((uint8 *)p)[bool_monster];
+         }
+      } while(p += repstride, repcount--);
+
+      sf++;
+   }
+}
+
+static int WriteStateChunkFast(StateMem *st, SFORMAT *sf)
+{
+   int32_t data_start_pos;
+   int32_t end_pos;
+
+   smem_write32le(st, 0);                // We'll come back and write this later.
+   smem_write32le(st, LayoutHash(sf, 2166136261U));
+
+   data_start_pos = st->loc;
+
+   SubWrite(st, sf, false);
+
+   end_pos = st->loc;
+
+   smem_seek(st, data_start_pos - 8, SSEEK_SET);
+   smem_write32le(st, end_pos - data_start_pos);
+   smem_seek(st, end_pos, SSEEK_SET);
+
+   return(1);
+}
+
+static int ReadStateChunkFast(StateMem *st, SSDescriptor *section)
+{
+   uint32_t size;
+   uint32_t hash;
+
+   if(smem_read32le(st, &size) != 4 || smem_read32le(st, &hash) != 4)
+      return(0);
+
+   if(size > (st->len - st->loc))
+      return(0);
+
+   if(hash != LayoutHash(section->sf, 2166136261U))
+   {
+      if(!section->optional)
+         log_cb( RETRO_LOG_ERROR, "Section %s doesn't match this configuration.\n", section->name );
+
+      smem_seek(st, size, SSEEK_CUR);
+      return(0);
+   }
+
+   const uint32_t data_start_pos = st->loc;
+
+   SubReadFast(st, section->sf);
+
+   if(st->loc != data_start_pos + size)
+   {
+      log_cb( RETRO_LOG_ERROR, "Section %s has the wrong size.\n", section->name );
+      smem_seek(st, data_start_pos + size, SSEEK_SET);
+      return(0);
+   }
+
+   return(1);
+}
+
 /* This function is called by the game driver(NES, GB, GBA) to save a state. */
 static int MDFNSS_StateAction_internal( void *st_p, int load, int data_only, SSDescriptor *section)
 {
 	StateMem *st = (StateMem*)st_p;
 
+	if ( st->fast )
+		return(load ? ReadStateChunkFast(st, section) : WriteStateChunkFast(st, section->sf));
+
 	if ( load )
    {
       char sname[32];
@@ -370,6 +553,7 @@ int MDFNSS_StateAction(void *st_p, int load, int data_only, SFORMAT *sf, const c
 
    love.sf       = sf;
    love.name     = name;
+   love.optional = optional;
 
    return(MDFNSS_StateAction_internal(st, load, 0, &love));
 }
@@ -381,7 +565,7 @@ int MDFNSS_SaveSM(void *st_p, uint32_t ver, const void*, const void*, const void
 	int success;
 	uint8_t header[32];
 	StateMem *st = (StateMem*)st_p;
-	static const char *header_magic = "MDFNSVST";
+	const char *header_magic = st->delta ? "MDFNSVDS" : (st->fast ? "MDFNSVFS" : "MDFNSVST");
 	int neowidth = 0, neoheight = 0;
 
 	// Write header.
@@ -399,11 +583,19 @@ int MDFNSS_SaveSM(void *st_p, uint32_t ver, const void*, const void*, const void
 	uint32_t sizy = st->loc;
 	smem_seek(st, 16 + 4, SEEK_SET);
 	smem_write32le(st, sizy);
+	smem_seek(st, sizy, SEEK_SET);
+
+	if ( st->overflow ) {
+		log_cb( RETRO_LOG_ERROR, "[MDFNSS_SaveSM] Save state doesn't fit in %u bytes.\n", st->malloced );
+		return(0);
+	}
 
 	// Success!
 	return success;
 }
 
+static int LoadSMCompressed(StateMem *st, uint32_t ver);
+
 int MDFNSS_LoadSM(void *st_p, uint32_t ver)
 {
 	int success;
@@ -411,10 +603,19 @@ int MDFNSS_LoadSM(void *st_p, uint32_t ver)
 	uint32_t stateversion;
 	StateMem *st = (StateMem*)st_p;
 
+	if ( (st->len - st->loc) >= 8 && !memcmp( st->data + st->loc, "MDFNSVZL", 8 ) )
+		return LoadSMCompressed( st, ver );
+
 	smem_read( st, header, 32 );
 
 	// Invalid header?
-	if ( memcmp( header, "MDFNSVST", 8 ) ) {
+	if ( !memcmp( header, "MDFNSVFS", 8 ) )
+		st->fast = true;
+	else if ( !memcmp( header, "MDFNSVST", 8 ) )
+		st->fast = false;
+	else if ( st->delta && !memcmp( header, "MDFNSVDS", 8 ) )
+		st->fast = true;
+	else {
 		log_cb( RETRO_LOG_ERROR, "[MDFNSS_LoadSM] Invalid save-state header.\n" );
 		return(0);
 	}
@@ -432,3 +633,176 @@ int MDFNSS_LoadSM(void *st_p, uint32_t ver)
 	// Success?
 	return success;
 }
+
+//
+// Compressed container, for states that are stored rather than kept in memory: "MDFNSVZL", the sizes of the state and of
+// the compressed data(32-bit little endian), and a zlib stream of the state as MDFNSS_SaveSM() writes it.  MDFNSS_LoadSM()
+// recognizes it by the magic; containers don't nest.
+//
+// Loading only needs inflate, which every build has.  Saving needs deflate, which the bundled zlib leaves out, so it's
+// only available when building against a complete zlib(SYSTEM_ZLIB=1, which defines HAVE_ZLIB_DEFLATE); otherwise,
+// MDFNSS_SaveSMCompressed() writes the plain state.
+//
+// Most of a state is large, mostly empty buffers(VDP1 framebuffers, cartridge and backup RAM), so even the fastest
+// deflate level shrinks it many times over.
+//
+enum : uint32_t { ZL_HEADER_SIZE = 8 + 4 + 4 };	// Magic, sizes.
+enum : uint32_t { ZL_MAX_STATE_SIZE = 1U << 28 };
+enum : uint32_t { ZL_CHUNK_SIZE = 0x4000 };
+
+// The bundled zlib is built without its default allocator.
+static voidpf ZAlloc(voidpf opaque, uInt items, uInt size)
+{
+   return calloc(items, size);
+}
+
+static void ZFree(voidpf opaque, voidpf address)
+{
+   free(address);
+}
+
+int MDFNSS_SaveSMCompressed(void *st_p, uint32_t ver)
+{
+   StateMem *st = (StateMem*)st_p;
+   const uint32_t start = st->loc;
+
+   if(!MDFNSS_SaveSM(st, ver, NULL, NULL, NULL))
+      return(0);
+
+#ifdef HAVE_ZLIB_DEFLATE
+   {
+      //
+      // The state is written as usual, then compressed in place: deflate() copies its input into its own window, so
+      // the compressed stream can overwrite what has already been read, as long as it stays behind.
+      //
+      const uint32_t raw_len = st->loc - start;
+      uint8_t *dst = st->data + start;
+      uint8_t buf[ZL_CHUNK_SIZE];
+      uint32_t zl_len = 0;
+      z_stream zs;
+      int zr = Z_MEM_ERROR;
+
+      memset(&zs, 0, sizeof(zs));
+      zs.zalloc = ZAlloc;
+      zs.zfree = ZFree;
+
+      if(deflateInit(&zs, Z_BEST_SPEED) == Z_OK)
+      {
+         zs.next_in = dst;
+         zs.avail_in = raw_len;
+
+         do
+         {
+            uint32_t n;
+
+            zs.next_out = buf;
+            zs.avail_out = sizeof(buf);
+            zr = deflate(&zs, Z_FINISH);
+            n = sizeof(buf) - zs.avail_out;
+
+            // Would overwrite state data deflate() hasn't read yet(or it isn't getting any smaller); give up.
+            if((ZL_HEADER_SIZE + zl_len + n) > (uint32_t)(zs.next_in - dst))
+            {
+               zr = Z_BUF_ERROR;
+               break;
+            }
+
+            memcpy(dst + ZL_HEADER_SIZE + zl_len, buf, n);
+            zl_len += n;
+         } while(zr == Z_OK);
+
+         deflateEnd(&zs);
+      }
+
+      if(zr == Z_STREAM_END)
+      {
+         memcpy(dst, "MDFNSVZL", 8);
+         MDFN_en32lsb(dst + 8, raw_len);
+         MDFN_en32lsb(dst + 12, zl_len);
+
+         st->loc = st->len = start + ZL_HEADER_SIZE + zl_len;
+
+         return(1);
+      }
+
+      // Part of the state may have been overwritten already; store it as-is instead.
+      st->loc = start;
+      st->len = start;
+
+      return MDFNSS_SaveSM(st, ver, NULL, NULL, NULL);
+   }
+#else
+   return(1);
+#endif
+}
+
+static int LoadSMCompressed(StateMem *st, uint32_t ver)
+{
+   const uint8_t *src = st->data + st->loc;
+   uint32_t raw_len, zl_len;
+   z_stream zs;
+   StateMem raw;
+   int zr;
+   int success;
+
+   if((st->len - st->loc) < ZL_HEADER_SIZE)
+   {
+      log_cb( RETRO_LOG_ERROR, "[MDFNSS_LoadSM] Truncated compressed save state.\n" );
+      return(0);
+   }
+
+   raw_len = MDFN_de32lsb(src + 8);
+   zl_len = MDFN_de32lsb(src + 12);
+
+   if(zl_len > (st->len - st->loc - ZL_HEADER_SIZE) || raw_len > ZL_MAX_STATE_SIZE)
+   {
+      log_cb( RETRO_LOG_ERROR, "[MDFNSS_LoadSM] Truncated compressed save state.\n" );
+      return(0);
+   }
+
+   memset(&raw, 0, sizeof(raw));
+
+   if(!(raw.data = (uint8_t *)malloc(raw_len ? raw_len : 1)))
+      return(0);
+
+   memset(&zs, 0, sizeof(zs));
+   zs.zalloc = ZAlloc;
+   zs.zfree = ZFree;
+
+   if(inflateInit(&zs) != Z_OK)
+   {
+      free(raw.data);
+      return(0);
+   }
+
+   zs.next_in = (Bytef *)src + ZL_HEADER_SIZE;
+   zs.avail_in = zl_len;
+   zs.next_out = raw.data;
+   zs.avail_out = raw_len;
+
+   zr = inflate(&zs, Z_FINISH);
+   inflateEnd(&zs);
+
+   if(zr != Z_STREAM_END || zs.total_out != raw_len)
+   {
+      log_cb( RETRO_LOG_ERROR, "[MDFNSS_LoadSM] Error decompressing save state.\n" );
+      free(raw.data);
+      return(0);
+   }
+
+   if(raw_len >= 8 && !memcmp(raw.data, "MDFNSVZL", 8))
+   {
+      log_cb( RETRO_LOG_ERROR, "[MDFNSS_LoadSM] Nested compressed save state.\n" );
+      free(raw.data);
+      return(0);
+   }
+
+   raw.len = raw_len;
+
+   success = MDFNSS_LoadSM(&raw, ver);
+
+   st->loc += ZL_HEADER_SIZE + zl_len;
+   free(raw.data);
+
+   return success;
+}
@@ -34,10 +34,18 @@ typedef struct
    uint32_t len;
    uint32_t malloced;
    uint32_t initial_malloc; // A setting!
+   bool fixed;              // "data" is a caller-owned buffer of "malloced" bytes, written to in place and never reallocated.
+   bool overflow;           // Set when a write didn't fit in a fixed buffer.
+   bool fast;               // Layout without variable names, for states that stay in this session; see state.cpp.
+   bool delta;              // Rewind/run-ahead snapshot, carrying only the changed pages of paged variables; implies "fast".
+   bool sizing;             // Only measuring: writes advance "loc" and "len" without storing anything("data" stays NULL).
 } StateMem;
 
 int MDFNSS_SaveSM(void *st, uint32_t ver, const void*, const void*, const void*);
-int MDFNSS_LoadSM(void *st, uint32_t ver);
+int MDFNSS_LoadSM(void *st, uint32_t ver);	// Also takes the compressed container written by MDFNSS_SaveSMCompressed().
+
+// Like MDFNSS_SaveSM(), but zlib-compressed when the build can and that makes it smaller; see state.cpp.
+int MDFNSS_SaveSMCompressed(void *st, uint32_t ver);
 
 // Flag for a single, >= 1 byte native-endian variable
 #define MDFNSTATE_RLSB            0x80000000
@@ -169,6 +177,24 @@ static INLINE SFORMAT SFBASE_(T* const v, const uint32 count, const char* const
 #define SFPTRDN(x, ...)		SFBASE_<double>((x), __VA_ARGS__)
 #define SFPTRD(x, ...)		SFBASE_<double>((x), __VA_ARGS__, #x)
 
+//
+// Variables of at least SS_PAGE_SIZE bytes(per element, for arrays of structures) are paged: rewind and run-ahead
+// snapshots only carry the pages of them that changed since the previous snapshot(see state_rewind.cpp).  Changed pages
+// are found by comparing against the ring's copy, except for variables whose writers flag the pages they modify in a
+// dirty map registered with MDFNSS_TrackDirty().
+//
+enum : uint32 { SS_PAGE_SHIFT = 11 };
+enum : uint32 { SS_PAGE_SIZE = 1U << SS_PAGE_SHIFT };
+
+static INLINE void SS_MarkDirty(uint8* dirty, const uint32 offset) { dirty[offset >> SS_PAGE_SHIFT] = 0xFF; }
+
+// "dirty" has one byte per page of "data"; each snapshot ring owns one bit, set for pages written since its last snapshot.
+void MDFNSS_TrackDirty(const void* data, const uint32 size, uint8* dirty);
+void MDFNSS_UntrackDirty(const void* data);
+
+// For writers that only have a host pointer(e.g. cheats through the CPU fast map); a no-op outside tracked variables.
+void MDFNSS_MarkDirtyAt(const void* p);
+
 #define SFLINK(x) { nullptr, (x), ~0U, 0, 0, 0 }
 
 #define SFEND { nullptr, nullptr, 0, 0, 0, 0 }
@@ -0,0 +1,419 @@
+/* Mednafen - Multi-system Emulator
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#include <boolean.h>
+#include <libretro.h>
+
+#include "mednafen-types.h"
+#include "state.h"
+#include "state_rewind.h"
+
+extern retro_log_printf_t log_cb;
+
+//
+// Snapshot rings.
+//
+// Each snapshot is a fast layout state without the paged variables, plus an undo log: the contents, as of the previous
+// snapshot, of every page that changed between the two.  A ring keeps a copy of the paged variables as of its newest
+// snapshot, so rewinding to it only needs to put back the pages changed since(as found by dirty maps, or by comparing),
+// and going back one more snapshot then just means applying the newest one's undo log to that copy.
+//
+// There are two rings, each owning one bit of the dirty maps: the rewind ring, and the run-ahead ring, which only ever
+// holds the one snapshot speculative frames are run from(so it keeps no undo log).  Pages put back by either are flagged
+// for the other.
+//
+// Paged variables are identified by the order in which they're visited, which is the same for saving and loading(the
+// fast layout depends on that too).
+//
+struct Chunk
+{
+ uint8* data;
+ uint8* dirty;	// Dirty map, or NULL to compare against "copy".
+ uint32 size;
+ std::vector<uint8> copy;
+};
+
+struct Snapshot
+{
+ std::vector<uint8> state;
+ std::vector<uint8> undo;	// (uint32 chunk index, uint32 page index, page data) for each page.
+};
+
+struct SnapshotRing
+{
+ const uint8 dirty_bit;
+ unsigned depth;
+ std::deque<Snapshot> snapshots;
+ std::vector<Chunk> chunks;
+ bool primed;	// "chunks" holds the paged variables as of snapshots.back().
+ StateMem scratch;
+};
+
+struct DirtyMap
+{
+ const uint8* data;
+ uint32 size;
+ uint8* dirty;
+};
+
+static std::vector<DirtyMap> DirtyMaps;
+
+static bool Running = false;
+static SnapshotRing RewindRing = { 0x01 };
+static SnapshotRing RunAheadRing = { 0x02, 1 };
+
+static SnapshotRing* Cur;	// Ring being saved or loaded.
+static size_t ChunkPos;
+static bool ChunkMismatch;
+static std::vector<uint8>* Undo;	// NULL if not keeping an undo log.
+
+void MDFNSS_TrackDirty(const void* data, const uint32 size, uint8* dirty)
+{
+ MDFNSS_UntrackDirty(data);
+
+ DirtyMaps.push_back({ (const uint8*)data, size, dirty });
+ memset(dirty, 0xFF, (size + SS_PAGE_SIZE - 1) >> SS_PAGE_SHIFT);
+}
+
+void MDFNSS_UntrackDirty(const void* data)
+{
+ for(auto it = DirtyMaps.begin(); it != DirtyMaps.end(); ++it)
+ {
+  if(it->data == data)
+  {
+   DirtyMaps.erase(it);
+   break;
+  }
+ }
+}
+
+void MDFNSS_MarkDirtyAt(const void* p)
+{
+ for(auto const& dm : DirtyMaps)
+ {
+  if((const uint8*)p >= dm.data && (const uint8*)p < dm.data + dm.size)
+   SS_MarkDirty(dm.dirty, (const uint8*)p - dm.data);
+ }
+}
+
+static uint8* FindDirtyMap(const void* data, const uint32 size)
+{
+ for(auto const& dm : DirtyMaps)
+ {
+  if(dm.data == data && dm.size == size)
+   return dm.dirty;
+ }
+
+ return NULL;
+}
+
+static INLINE uint32 NumPages(const Chunk& c)
+{
+ return (c.size + SS_PAGE_SIZE - 1) >> SS_PAGE_SHIFT;
+}
+
+static INLINE uint32 PageLength(const Chunk& c, const uint32 page)
+{
+ return std::min<uint32>(SS_PAGE_SIZE, c.size - (page << SS_PAGE_SHIFT));
+}
+
+static INLINE bool PageChanged(const Chunk& c, const uint32 page)
+{
+ const uint32 offs = page << SS_PAGE_SHIFT;
+
+ if(c.dirty && !(c.dirty[page] & Cur->dirty_bit))
+  return false;
+
+ return memcmp(c.data + offs, &c.copy[offs], PageLength(c, page)) != 0;
+}
+
+static INLINE void ClearDirty(const Chunk& c)
+{
+ if(c.dirty)
+ {
+  const uint32 num_pages = NumPages(c);
+
+  for(uint32 page = 0; page < num_pages; page++)
+   c.dirty[page] &= ~Cur->dirty_bit;
+ }
+}
+
+// Visits each element of "sf" as a separate chunk, matching it up with the ring's chunks(or adding it, when not primed yet).
+template<typename T>
+static INLINE void ForEachChunk(const SFORMAT* sf, T&& func)
+{
+ std::vector<Chunk>& chunks = Cur->chunks;
+ uint8* p = (uint8*)sf->data;
+ uint32 repcount = sf->repcount;
+
+ do
+ {
+  if(!Cur->primed)
+  {
+   Chunk c;
+
+   c.data = p;
+   c.dirty = sf->repcount ? NULL : FindDirtyMap(p, sf->size);
+   c.size = sf->size;
+   chunks.push_back(std::move(c));
+  }
+  else if(ChunkPos >= chunks.size() || chunks[ChunkPos].data != p || chunks[ChunkPos].size != sf->size)
+  {
+   ChunkMismatch = true;
+   return;
+  }
+
+  func(chunks[ChunkPos], ChunkPos);
+  ChunkPos++;
+ } while(p += sf->repstride, repcount--);
+}
+
+void MDFNSR_SavePaged(const SFORMAT* sf)
+{
+ ForEachChunk(sf, [](Chunk& c, const size_t index)
+ {
+  const uint32 num_pages = NumPages(c);
+
+  if(!Cur->primed)
+   c.copy.assign(c.data, c.data + c.size);
+  else
+  {
+   for(uint32 page = 0; page < num_pages; page++)
+   {
+    if(PageChanged(c, page))
+    {
+     const uint32 offs = page << SS_PAGE_SHIFT;
+     const uint32 len = PageLength(c, page);
+
+     if(Undo)
+     {
+      const uint32 hdr[2] = { (uint32)index, page };
+
+      Undo->insert(Undo->end(), (const uint8*)hdr, (const uint8*)(hdr + 2));
+      Undo->insert(Undo->end(), &c.copy[offs], &c.copy[offs] + len);
+     }
+     memcpy(&c.copy[offs], c.data + offs, len);
+    }
+   }
+  }
+
+  ClearDirty(c);
+ });
+}
+
+void MDFNSR_LoadPaged(const SFORMAT* sf)
+{
+ ForEachChunk(sf, [](Chunk& c, const size_t index)
+ {
+  const uint32 num_pages = NumPages(c);
+
+  for(uint32 page = 0; page < num_pages; page++)
+  {
+   if(PageChanged(c, page))
+   {
+    const uint32 offs = page << SS_PAGE_SHIFT;
+
+    memcpy(c.data + offs, &c.copy[offs], PageLength(c, page));
+
+    if(c.dirty)
+     c.dirty[page] = 0xFF;
+   }
+  }
+
+  ClearDirty(c);
+ });
+}
+
+// Turns the copy of the paged variables into that of the snapshot before "s", flagging the pages that now differ.
+static void ApplyUndo(SnapshotRing* ring, const Snapshot& s)
+{
+ const uint8* p = s.undo.data();
+ const uint8* const end = p + s.undo.size();
+
+ while(p < end)
+ {
+  uint32 hdr[2];
+
+  memcpy(hdr, p, sizeof(hdr));
+  p += sizeof(hdr);
+
+  Chunk& c = ring->chunks[hdr[0]];
+  const uint32 offs = hdr[1] << SS_PAGE_SHIFT;
+  const uint32 len = PageLength(c, hdr[1]);
+
+  memcpy(&c.copy[offs], p, len);
+  p += len;
+
+  if(c.dirty)
+   c.dirty[hdr[1]] |= ring->dirty_bit;
+ }
+}
+
+static void Flush(SnapshotRing* ring)
+{
+ ring->snapshots.clear();
+ ring->chunks.clear();
+ ring->primed = false;
+}
+
+static void FreeScratch(SnapshotRing* ring)
+{
+ if(ring->scratch.data)
+ {
+  free(ring->scratch.data);
+  ring->scratch.data = NULL;
+  ring->scratch.malloced = 0;
+ }
+}
+
+void MDFN_StateEvilFlush(void)
+{
+ Flush(&RewindRing);
+ Flush(&RunAheadRing);
+}
+
+void MDFN_StateEvilBegin(const unsigned depth)
+{
+ Flush(&RewindRing);
+
+ RewindRing.depth = std::max<unsigned>(1, depth);
+ Running = true;
+}
+
+void MDFN_StateEvilEnd(void)
+{
+ Flush(&RewindRing);
+ FreeScratch(&RewindRing);
+
+ Running = false;
+}
+
+bool MDFN_StateEvilIsRunning(void)
+{
+ return Running;
+}
+
+static void InitStateMem(StateMem* st)
+{
+ st->loc = 0;
+ st->len = 0;
+ st->initial_malloc = 0;
+ st->fixed = false;
+ st->overflow = false;
+ st->fast = true;
+ st->delta = true;
+ st->sizing = false;
+}
+
+static bool Push(SnapshotRing* ring)
+{
+ Snapshot s;
+
+ if(ring->snapshots.size() >= ring->depth)
+ {
+  s = std::move(ring->snapshots.front());
+  ring->snapshots.pop_front();
+ }
+
+ s.undo.clear();
+ Cur = ring;
+ Undo = (ring->depth > 1) ? &s.undo : NULL;
+ ChunkPos = 0;
+ ChunkMismatch = false;
+
+ InitStateMem(&ring->scratch);
+
+ if(!MDFNSS_SaveSM(&ring->scratch, 0, NULL, NULL, NULL) || ChunkMismatch || ChunkPos != ring->chunks.size())
+ {
+  log_cb(RETRO_LOG_ERROR, "[State Rewind] Snapshot failed; starting over.\n");
+  Flush(ring);
+  return false;
+ }
+
+ s.state.assign(ring->scratch.data, ring->scratch.data + ring->scratch.len);
+ ring->snapshots.push_back(std::move(s));
+ ring->primed = true;
+
+ return true;
+}
+
+static bool Rewind(SnapshotRing* ring)
+{
+ StateMem st;
+
+ if(ring->snapshots.empty())
+  return false;
+
+ Cur = ring;
+ ChunkPos = 0;
+ ChunkMismatch = false;
+
+ st.data = ring->snapshots.back().state.data();
+ st.malloced = 0;
+ InitStateMem(&st);
+ st.len = ring->snapshots.back().state.size();
+
+ if(!MDFNSS_LoadSM(&st, 0) || ChunkMismatch || ChunkPos != ring->chunks.size())
+ {
+  log_cb(RETRO_LOG_ERROR, "[State Rewind] Loading snapshot failed; starting over.\n");
+  Flush(ring);
+  return false;
+ }
+
+ if(ring->snapshots.size() > 1)
+ {
+  ApplyUndo(ring, ring->snapshots.back());
+  ring->snapshots.pop_back();
+ }
+
+ return true;
+}
+
+bool MDFN_StateEvil(const bool rewind)
+{
+ if(!Running)
+  return false;
+
+ if(rewind)
+  return Rewind(&RewindRing);
+
+ Push(&RewindRing);
+
+ return false;
+}
+
+bool MDFN_RunAheadSave(void)
+{
+ return Push(&RunAheadRing);
+}
+
+bool MDFN_RunAheadLoad(void)
+{
+ return Rewind(&RunAheadRing);
+}
+
+void MDFN_RunAheadEnd(void)
+{
+ Flush(&RunAheadRing);
+ FreeScratch(&RunAheadRing);
+}
@@ -0,0 +1,33 @@
+#ifndef __MDFN_STATE_REWIND_H
+#define __MDFN_STATE_REWIND_H
+
+#include "state.h"
+
+// Starts(or restarts, dropping all snapshots) the rewind ring, keeping up to "depth" snapshots.
+void MDFN_StateEvilBegin(const unsigned depth);
+void MDFN_StateEvilEnd(void);
+bool MDFN_StateEvilIsRunning(void);
+
+// Drops all snapshots(rewind and run-ahead); call after anything modifies emulated memory behind the dirty maps' back(state load, power-on).
+void MDFN_StateEvilFlush(void);
+
+//
+// Call once per frame, before emulating it: with "rewind" false, takes a snapshot; with "rewind" true, returns to the
+// newest snapshot and discards it(except for the oldest one, which is kept), so that each call goes back one further.
+// Returns false if there was nothing to rewind to.
+//
+bool MDFN_StateEvil(const bool rewind);
+
+//
+// Run-ahead: MDFN_RunAheadSave() snapshots the state after the frame that counts, and MDFN_RunAheadLoad() goes back to
+// it after the speculative frames.  Both return false on failure.  MDFN_RunAheadEnd() frees the snapshot.
+//
+bool MDFN_RunAheadSave(void);
+bool MDFN_RunAheadLoad(void);
+void MDFN_RunAheadEnd(void);
+
+// For state.cpp, for the paged variables of snapshots(StateMem::delta).
+void MDFNSR_SavePaged(const SFORMAT* sf);
+void MDFNSR_LoadPaged(const SFORMAT* sf);
+
+#endif